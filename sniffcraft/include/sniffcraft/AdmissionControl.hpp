@@ -0,0 +1,87 @@
+#pragma once
+
+#include <asio.hpp>
+
+#include "sniffcraft/Configuration.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+// Connection limits checked when a client is accepted, before the
+// session is created (no logger thread, no log file, no upstream
+// connection, only the accepted socket). Called
+// from all the acceptor threads, per-IP state is spread over locked stripes
+class AdmissionControl
+{
+public:
+    AdmissionControl(const Configuration& conf);
+
+    // True if the connection is accepted, it then counts as
+    // active until Release is called with the same address
+    const bool TryAdmit(const asio::ip::address& address);
+    void Release(const asio::ip::address& address);
+
+private:
+    struct TokenBucket
+    {
+        double tokens;
+        std::chrono::steady_clock::time_point last_refill;
+    };
+
+    struct IpState
+    {
+        unsigned int active;
+        TokenBucket bucket;
+    };
+
+    // IPv6 address, IPv4 ones are mapped
+    struct IpKey
+    {
+        unsigned long long high;
+        unsigned long long low;
+
+        bool operator==(const IpKey& other) const;
+    };
+
+    struct IpKeyHash
+    {
+        size_t operator()(const IpKey& key) const;
+    };
+
+    struct Stripe
+    {
+        std::mutex mutex;
+        std::unordered_map<IpKey, IpState, IpKeyHash> states;
+        // Size after the last cleanup, the next one is done when it doubles
+        size_t cleanup_size;
+    };
+
+    static const IpKey MakeKey(const asio::ip::address& address);
+    Stripe& GetStripe(const IpKey& key);
+    // Global connection count and rate, the slot is taken if true is returned
+    const bool TryAdmitGlobal(const std::chrono::steady_clock::time_point& now);
+    // Refill then take one token, false if empty. rate of 0 means no limit
+    const bool TakeToken(TokenBucket& bucket, const double rate, const double burst, const std::chrono::steady_clock::time_point& now) const;
+    // Remove the IPs without active connection and with a full bucket.
+    // stripe mutex must be locked
+    void Cleanup(Stripe& stripe, const std::chrono::steady_clock::time_point& now);
+
+private:
+    static const size_t NUM_STRIPES = 64;
+
+    const unsigned int max_connections_;
+    const unsigned int max_connections_per_ip_;
+    const double rate_;
+    const double burst_;
+    const double rate_per_ip_;
+    const double burst_per_ip_;
+
+    std::atomic<unsigned int> active_connections_;
+    std::mutex global_bucket_mutex_;
+    TokenBucket global_bucket_;
+
+    std::array<Stripe, NUM_STRIPES> stripes_;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Process-wide worker compressing finished log files with gzip.
+// Jobs are executed in the order they are submitted, so removing
+// a file after asking for its compression is always safe
+class BackgroundCompressor
+{
+public:
+    static BackgroundCompressor& GetInstance();
+
+    // Compress path into path + ".gz" and remove path
+    void Compress(const std::string& path);
+    // Remove path (and path + ".gz" if it exists)
+    void Remove(const std::string& path);
+
+private:
+    BackgroundCompressor();
+    ~BackgroundCompressor();
+    BackgroundCompressor(const BackgroundCompressor&) = delete;
+    BackgroundCompressor& operator=(const BackgroundCompressor&) = delete;
+
+    void Push(const std::string& path, const bool compress);
+    void WorkLoop();
+    void CompressFile(const std::string& path);
+
+private:
+    struct Job
+    {
+        std::string path;
+        bool compress;
+    };
+
+    std::thread worker_thread;
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_condition;
+    std::deque<Job> jobs;
+    bool is_running;
+};
@@ -1,8 +1,34 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
+struct z_stream_s;
 
-std::vector<unsigned char> Compress(const std::vector<unsigned char> &raw, const int &start = 0, const int &size = -1);
-std::vector<unsigned char> Decompress(const std::vector<unsigned char> &compressed, const int &start = 0, const int &size = -1);
+
+// Deflate stream kept between packets, so its state is allocated
+// once (on first use) and only reset for each packet. Not thread safe
+class Compressor
+{
+public:
+    Compressor();
+    ~Compressor();
+
+    // Compress size bytes of raw and append them to output
+    void Compress(const unsigned char* raw, const size_t size, std::vector<unsigned char>& output);
+
+private:
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+private:
+    // nullptr until the first packet
+    z_stream_s* stream_;
+};
+
+
+// Decompress exactly output_size bytes in output, throws if the decompressed data don't have this size
+void Decompress(const unsigned char* compressed, const size_t size, unsigned char* output, const size_t output_size);
+// Only decompress the first output_size bytes, returns the number of bytes written in output
+size_t DecompressPrefix(const unsigned char* compressed, const size_t size, unsigned char* output, const size_t output_size);
 
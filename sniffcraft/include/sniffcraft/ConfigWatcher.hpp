@@ -0,0 +1,49 @@
+#pragma once
+
+#include "sniffcraft/Configuration.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Watch a conf file for the whole process and publish a new
+// Configuration each time it changes, using inotify on Linux
+// and checking the modification time every few seconds elsewhere
+class ConfigWatcher
+{
+public:
+    ConfigWatcher(const std::string& path);
+    ~ConfigWatcher();
+
+    // Latest loaded configuration, never nullptr
+    std::shared_ptr<const Configuration> GetConfiguration() const;
+    // Incremented each time a new configuration is published, can be used
+    // to cheaply check if GetConfiguration needs to be called again
+    const unsigned int GetVersion() const;
+
+private:
+    void Reload(const bool force);
+    void WatchLoop();
+#ifdef __linux__
+    void InotifyLoop(const int inotify_fd);
+#endif
+    void PollingLoop();
+
+private:
+    std::string conf_path;
+
+    // Only accessed through std::atomic_load/std::atomic_store
+    std::shared_ptr<const Configuration> configuration;
+    std::atomic<unsigned int> version;
+
+    std::time_t last_time_modified;
+
+    std::thread watch_thread;
+    std::mutex watch_mutex;
+    std::condition_variable watch_condition;
+    std::atomic<bool> is_running;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "sniffcraft/enums.hpp"
+
+#include <protocolCraft/enums.hpp>
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <memory>
+
+// "*" in a packet list, stored with the ids
+const int ALL_PACKETS_ID = -1;
+
+// TCP options of one leg of the sessions (client or server side).
+// 0 keeps the system default
+struct SocketOptions
+{
+    SocketOptions();
+
+    bool nodelay;
+    int send_buffer;
+    int receive_buffer;
+    bool keepalive;
+    int keepalive_idle_s;
+    int keepalive_interval_s;
+    int keepalive_count;
+    // Linux only
+    unsigned int user_timeout_ms;
+    // Linux only, set again after each read as the kernel resets it
+    bool quickack;
+};
+
+// Content of a conf file. Once loaded, a Configuration is never
+// modified, a new one is created instead when the file changes,
+// so it can be shared between all the sessions without locking
+struct Configuration
+{
+    Configuration();
+
+    const bool IsIgnored(const ProtocolCraft::ConnectionState connection_state, const Origin origin, const int id) const;
+    const bool IsDetailed(const ProtocolCraft::ConnectionState connection_state, const Origin origin, const int id) const;
+    // True if "*" is in the ignored list
+    const bool IsAllIgnored(const ProtocolCraft::ConnectionState connection_state, const Origin origin) const;
+
+    bool log_to_console;
+    LogMode log_mode;
+    std::chrono::seconds packet_stats_interval;
+    size_t packet_stats_top_n;
+    LogFormat log_format;
+    TimestampFormat timestamp_format;
+
+    // Session files location, rotation and retention
+    std::string log_directory;
+    unsigned long long log_rotation_size;
+    std::chrono::seconds log_rotation_duration;
+    bool log_compression;
+    size_t log_max_segments;
+
+    // Latency instrumentation
+    bool latency_stats_enabled;
+    std::chrono::seconds latency_dump_interval;
+    std::string latency_stats_file;
+    size_t latency_top_packets;
+
+    // Metrics HTTP endpoint
+    bool metrics_enabled;
+    unsigned short metrics_port;
+
+    // Read at startup, 0 to decode inline
+    unsigned int decode_threads;
+
+    // Read at startup, threads writing the session logs of all the routes
+    unsigned int log_threads;
+
+    // Read at startup
+    unsigned int listen_workers;
+    bool listen_reuse_port;
+    bool listen_ipv6;
+    // 0 for the system max
+    int listen_backlog;
+
+    // Read at startup, 0 for no limit. Rates are in connections
+    // per second, bursts the number of connections allowed at once
+    unsigned int admission_max_connections;
+    unsigned int admission_max_connections_per_ip;
+    double admission_rate;
+    double admission_burst;
+    double admission_rate_per_ip;
+    double admission_burst_per_ip;
+
+    // Read when a session starts, 0 to disable.
+    // Handshake: from the connection to the Handshake packet,
+    // login: from the Handshake to the LoginSuccess packet,
+    // idle: without any data received from either side
+    std::chrono::seconds handshake_timeout;
+    std::chrono::seconds login_timeout;
+    std::chrono::seconds idle_timeout;
+
+    // Read when a session starts
+    SocketOptions client_socket_options;
+    SocketOptions server_socket_options;
+
+    size_t log_queue_capacity;
+    LogOverflowPolicy log_queue_overflow_policy;
+    unsigned int log_queue_sample_rate;
+
+    std::map<std::pair<ProtocolCraft::ConnectionState, Origin>, std::set<int> > ignored_packets;
+    std::map<std::pair<ProtocolCraft::ConnectionState, Origin>, std::set<int> > detailed_packets;
+};
+
+// Read and parse the conf file at path, returns nullptr on error
+std::shared_ptr<const Configuration> LoadConfiguration(const std::string& path);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Process-wide cache of the upstream server endpoints, so
+// sessions don't wait for a resolution each time they
+// connect to the same address. Misses are resolved
+// asynchronously, without blocking the io thread
+class DNSCache
+{
+public:
+    typedef std::function<void(const asio::error_code&, const std::vector<asio::ip::tcp::endpoint>&)> ResolveHandler;
+
+    static DNSCache& GetInstance();
+
+    // handler is always called from io_context, never from within
+    // AsyncResolve, even if the endpoints are already in cache
+    void AsyncResolve(asio::io_context& io_context, const std::string& host, const unsigned short port, const ResolveHandler& handler);
+
+private:
+    DNSCache();
+
+    struct Entry
+    {
+        std::vector<asio::ip::tcp::endpoint> endpoints;
+        std::chrono::steady_clock::time_point expiration;
+    };
+
+    std::mutex cache_mutex;
+    std::map<std::pair<std::string, unsigned short>, Entry> cache;
+};
@@ -5,3 +5,6 @@
 
 const std::time_t GetModifiedTimestamp(const std::string& path);
 
+// Create path and all its missing parents, returns false on error
+const bool CreateDirectories(const std::string& path);
+
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+const int MAX_VARINT_LENGTH = 5;
+
+// A complete packet in a receive buffer
+struct FrameSpan
+{
+    // Start of the length varint
+    size_t offset;
+    // Size of the length varint
+    size_t header_length;
+    // Value of the length varint (size of what follows)
+    size_t length;
+};
+
+// Decode a VarInt without reading past available bytes.
+// Returns the number of bytes used, 0 if the VarInt is
+// incomplete or -1 if it's longer than 5 bytes
+const int DecodeVarInt(const unsigned char* data, const size_t available, int& value);
+
+// Number of bytes needed to encode value as a VarInt
+const size_t VarIntSize(const int value);
+
+// Write value as a VarInt at output, which must have VarIntSize(value) bytes
+void EncodeVarInt(const int value, unsigned char* output);
+
+// Find all the complete packets in data, in one pass and without
+// exceptions. spans is cleared and filled with the packets, the
+// returned value is the number of bytes they cover. Scanning stops
+// at the first incomplete (or invalid) packet
+const size_t ScanFrames(const unsigned char* data, const size_t size, std::vector<FrameSpan>& spans);
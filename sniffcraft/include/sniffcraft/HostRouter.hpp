@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+struct Upstream
+{
+    std::string ip;
+    unsigned short port;
+};
+
+// Choose the upstream server from the address the client asked
+// for in its Handshake. Filled once at startup, then only read
+class HostRouter
+{
+public:
+    void Add(const std::string& hostname, const Upstream& upstream);
+
+    // nullptr if this address has no route
+    const Upstream* Find(const std::string& handshake_address) const;
+
+    // Lower case, without Forge marker (everything after the first \0)
+    // nor the trailing dot of fully qualified names
+    static const std::string NormalizeHostname(const std::string& address);
+
+private:
+    std::unordered_map<std::string, Upstream> upstreams;
+};
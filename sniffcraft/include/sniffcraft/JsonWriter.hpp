@@ -0,0 +1,43 @@
+#pragma once
+
+#include <picojson/picojson.h>
+
+#include <string>
+#include <vector>
+
+// Append JSON directly into a string buffer, without building
+// any intermediate value. Commas between elements are handled
+// by the writer, output is compact (no spaces nor new lines)
+class JsonWriter
+{
+public:
+    JsonWriter(std::string& output_);
+
+    void StartObject();
+    void EndObject();
+    void StartArray();
+    void EndArray();
+
+    // Must be followed by exactly one value
+    void Key(const std::string& key);
+
+    void String(const std::string& value);
+    void String(const char* value, const size_t length);
+    void Integer(const long long value);
+    void Number(const double value);
+    void Bool(const bool value);
+    void Null();
+
+    // Stream an already existing picojson value
+    void Value(const picojson::value& value);
+
+private:
+    void BeforeValue();
+    void WriteEscaped(const char* value, const size_t length);
+
+private:
+    std::string& output;
+    // For each opened object/array, true if it already has an element
+    std::vector<bool> has_element;
+    bool after_key;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "sniffcraft/enums.hpp"
+
+#include <protocolCraft/enums.hpp>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Log-linear histogram (HDR-like): each power of two is split
+// into 2^SUB_BUCKET_BITS buckets, so the relative error on any
+// recorded value is below 1/2^SUB_BUCKET_BITS
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    // Values are in nanoseconds
+    void Record(const long long value);
+    void Merge(const LatencyHistogram& other);
+    void Reset();
+
+    const unsigned long long GetCount() const;
+    const long long GetMax() const;
+    // Upper bound of the bucket containing the given percentile (in [0, 100])
+    const long long GetPercentile(const double percentile) const;
+
+private:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    // Below 2^40 ns (~18 min), longer values are recorded in the last bucket
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    static const int BucketIndex(const long long value);
+    static const long long BucketUpperBound(const int index);
+
+private:
+    std::vector<unsigned long long> counts;
+    unsigned long long total_count;
+    long long max_value;
+};
+
+// Timestamps of a packet going through the proxy
+struct PacketTiming
+{
+    // async_read_some completion
+    std::chrono::steady_clock::time_point read;
+    // Full packet extracted from the incoming data
+    std::chrono::steady_clock::time_point framed;
+    // ParsePacket done, same as framed if not decoded
+    std::chrono::steady_clock::time_point parsed;
+    ProtocolCraft::ConnectionState connection_state;
+    // -1 if unknown when forwarded
+    int id;
+    // False if forwarded before being decoded (decode pool),
+    // nothing is then recorded in the parsing stage
+    bool decoded;
+};
+
+enum class LatencyStage
+{
+    Framing = 0,    // read --> framed
+    Parsing,        // framed --> parsed
+    Forwarding,     // parsed --> async_write completion
+    Total,          // read --> async_write completion
+    NUM_LATENCY_STAGE
+};
+
+// Per direction and per packet latency histograms
+class LatencyStats
+{
+public:
+    void Record(const Origin origin, const PacketTiming& timing, const std::chrono::steady_clock::time_point& written);
+    void Merge(const LatencyStats& other);
+    void Reset();
+    const bool IsEmpty() const;
+
+    // Human readable summary, with the top_n slowest packets per direction
+    const std::string ToString(const size_t top_n) const;
+
+    // Process-wide stats, fed by all the sessions
+    static void MergeIntoGlobal(const LatencyStats& stats);
+    static const std::string GlobalToString(const size_t top_n);
+
+private:
+    std::array<std::array<LatencyHistogram, static_cast<int>(LatencyStage::NUM_LATENCY_STAGE)>, 2> stage_histograms;
+    // Total latency per (origin, connection state, id)
+    std::map<std::tuple<int, int, int>, LatencyHistogram> packet_histograms;
+};
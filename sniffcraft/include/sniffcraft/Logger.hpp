@@ -1,57 +1,150 @@
 #pragma once
 
 #include "enums.hpp"
+#include "sniffcraft/Configuration.hpp"
+#include "sniffcraft/TimestampFormatter.hpp"
+#include "sniffcraft/RotatingLogFile.hpp"
+#include "sniffcraft/PacketStats.hpp"
 
 #include <protocolCraft/enums.hpp>
 #include <protocolCraft/Message.hpp>
 
-#include <picojson/picojson.h>
-
-#include <thread>
+#include <atomic>
 #include <mutex>
-#include <fstream>
+#include <condition_variable>
 #include <memory>
 #include <deque>
 #include <chrono>
-#include <set>
-#include <ctime>
+
+class ConfigWatcher;
+class LoggerService;
 
 struct LogItem
 {
     std::shared_ptr<ProtocolCraft::Message> msg;
     std::chrono::time_point<std::chrono::system_clock> date;
+    std::chrono::time_point<std::chrono::steady_clock> monotonic_date;
+    ProtocolCraft::ConnectionState connection_state;
+    Origin origin;
+    bool is_detailed;
+    // If not empty, this item is a text message and not a packet
+    std::string text;
+};
+
+// A logged message the logger doesn't reference anymore,
+// given back to the decoder to read another packet into it
+struct ReleasedMessage
+{
+    std::shared_ptr<ProtocolCraft::Message> msg;
     ProtocolCraft::ConnectionState connection_state;
     Origin origin;
 };
 
-class Logger
+// Session logger, items are written by the threads of a shared LoggerService.
+// A scheduled logger is kept alive by the service, so once Stop is called the
+// owner can release it right away and what is left in the queue is written
+// in the background
+class Logger : public std::enable_shared_from_this<Logger>
 {
 public:
-    Logger(const std::string &conf_path);
+    static std::shared_ptr<Logger> Create(LoggerService& service_, const ConfigWatcher& config_watcher_, const unsigned long long session_id_);
     ~Logger();
-    void Log(const std::shared_ptr<ProtocolCraft::Message> msg, const ProtocolCraft::ConnectionState connection_state, const Origin origin);
+
+    // Nothing can be logged after this, the remaining
+    // items are still written by the service
+    void Stop();
+
+    // Write the items queued so far, called by one service thread
+    // at a time. Return true if more items have been queued since
+    const bool WriteBatch();
+
+    // Give msg by moving it if it should be reused once written,
+    // see TakeReleasedMessages
+    void Log(std::shared_ptr<ProtocolCraft::Message> msg, const ProtocolCraft::ConnectionState connection_state, const Origin origin);
+    // True if TakeReleasedMessages has something to give, doesn't lock
+    const bool HasReleasedMessages() const;
+    // Move the written messages only referenced by the logger into messages
+    void TakeReleasedMessages(std::vector<ReleasedMessage>& messages);
+    // Write a text message (stats...) in the session log
+    void LogMessage(const std::string& message);
+
+    // True if this session only logs packet stats (decided when the session starts)
+    const bool IsStatsMode() const;
+    // Count a packet in stats mode, must never be called concurrently
+    void LogPacketStats(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id,
+        const size_t wire_size, const size_t uncompressed_size);
 
 private:
-    void LogConsume();
-    void LoadConfig(const std::string& path);
-    void LoadPacketsFromJson(const picojson::value& value, const ProtocolCraft::ConnectionState connection_state);
+    Logger(LoggerService& service_, const ConfigWatcher& config_watcher_, const unsigned long long session_id_);
+
+    // Must be called with log_mutex locked, true if
+    // the logger must be given to the service
+    bool Enqueue(std::unique_lock<std::mutex>& lock, LogItem& item);
+    void WriteLogItem(const LogItem& item, const Configuration& conf);
+    void WriteTextItem(const LogItem& item, const char* timestamp, const size_t timestamp_length);
+    void WriteJsonItem(const LogItem& item, const char* timestamp, const size_t timestamp_length);
+    // Information about the logger itself (dropped items...)
+    void WriteLoggerMessage(const std::string& message, const Configuration& conf);
+    // Must be called with log_mutex locked
+    bool MakeRoom(std::unique_lock<std::mutex>& lock, LogItem& item);
+    // Must be called with log_mutex locked
+    void UpdateConfiguration();
 
 private:
     std::chrono::time_point<std::chrono::system_clock> start_time;
 
-    std::thread log_thread;
+    LoggerService& service;
+
     std::mutex log_mutex;
-    std::condition_variable log_condition;
+    std::condition_variable queue_not_full_condition;
     std::deque<LogItem> logging_queue;
+    // Protected by log_mutex, items taken by the writer and not
+    // written yet. They count against the queue capacity
+    size_t in_flight_items;
+    // Protected by log_mutex, true while the logger is in the
+    // service ready list or being written by one of its threads
+    bool scheduled;
 
-    std::string logfile_path;
-    std::ofstream log_file;
-    bool is_running;
-    bool log_to_console;
+    const ConfigWatcher& config_watcher;
+    // Protected by log_mutex, refreshed from config_watcher
+    // when a new version has been published
+    std::shared_ptr<const Configuration> configuration;
+    unsigned int configuration_version;
 
-    std::time_t last_time_checked_log_file;
-    std::time_t last_time_log_file_modified;
+    // Protected by log_mutex
+    unsigned int sample_counter;
 
-    std::map<std::pair<ProtocolCraft::ConnectionState, Origin>, std::set<int> > ignored_packets;
-    std::map<std::pair<ProtocolCraft::ConnectionState, Origin>, std::set<int> > detailed_packets;
+    // Drop counters, protected by log_mutex and reset
+    // each time they are written into the log
+    unsigned long long dropped_items;
+    unsigned long long dropped_details;
+    unsigned long long sampled_out_items;
+
+    const unsigned long long session_id;
+    // Only used by the writing thread
+    RotatingLogFile log_file;
+    // Protected by log_mutex, set with the first logged item and kept
+    // for the whole session so a file never mixes formats
+    bool session_started;
+    LogFormat log_format;
+    // Protected by released_mutex, see TakeReleasedMessages
+    std::mutex released_mutex;
+    std::vector<ReleasedMessage> released_messages;
+    std::atomic<bool> has_released_messages;
+
+    // Only used by the writing thread
+    std::vector<ReleasedMessage> written_messages;
+    TimestampFormatter timestamp_formatter;
+    std::chrono::time_point<std::chrono::system_clock> batch_start_time;
+    std::string output_line;
+    // Stats mode only, used by the thread calling LogPacketStats
+    std::unique_ptr<PacketStats> packet_stats;
+    std::chrono::steady_clock::time_point last_packet_stats_dump;
+    std::chrono::seconds packet_stats_interval;
+    size_t packet_stats_top_n;
+    unsigned int packets_since_stats_check;
+
+    // Protected by log_mutex, set to false once
+    // nothing more can be logged
+    bool is_running;
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Logger;
+
+// Writer threads shared by the session loggers of all the routes.
+// Each Logger keeps its own queue and file. A logger with queued items
+// is put once in the ready list, and one thread at a time writes its
+// batch, so items of a session stay in order
+class LoggerService
+{
+public:
+    LoggerService(const size_t num_threads);
+    // Calls Stop without waiting if it has not been called before
+    ~LoggerService();
+
+    // Wait at most timeout for the queued items to be written, then join the
+    // threads (a batch being written is finished). Return false if some
+    // items were still waiting. Nothing is scheduled after this
+    const bool Stop(const std::chrono::milliseconds& timeout);
+
+    // Called by a logger when it has items to write and is not already scheduled
+    void Schedule(const std::shared_ptr<Logger>& logger);
+
+private:
+    void WorkLoop();
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex ready_mutex;
+    std::condition_variable ready_condition;
+    // Notified when the ready list is empty and no thread is writing
+    std::condition_variable idle_condition;
+    std::deque<std::shared_ptr<Logger> > ready_loggers;
+    // Protected by ready_mutex, threads writing a batch
+    size_t busy_threads;
+    bool is_running;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "sniffcraft/enums.hpp"
+
+#include <protocolCraft/enums.hpp>
+
+#include <string>
+
+enum class MetricCounter
+{
+    SessionsOpened = 0,
+    SessionsClosed,
+    BytesFromClient,
+    BytesFromServer,
+    DecompressCalls,
+    DecompressNanoseconds,
+    ParseExceptions,
+    LogItemsQueued,
+    LogItemsWritten,
+    LogItemsDropped,
+    DNSCacheHits,
+    DNSCacheMisses,
+    ConnectionsRejected,
+    DecodePacketsDropped,
+    NUM_METRIC_COUNTER
+};
+
+// Process-wide counters. Each thread writes in its own shard without
+// any synchronization beyond relaxed atomics, shards are only summed
+// when the metrics are scraped. Gauges are computed at scrape time as
+// differences of counters (e.g. opened - closed sessions)
+class Metrics
+{
+public:
+    static void Add(const MetricCounter counter, const unsigned long long value = 1);
+    static void AddPacket(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id);
+
+    // Everything in Prometheus text exposition format
+    static const std::string Scrape();
+};
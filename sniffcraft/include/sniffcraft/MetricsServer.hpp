@@ -0,0 +1,20 @@
+#pragma once
+
+#include <asio.hpp>
+
+// Minimal HTTP server answering GET /metrics with
+// the content of Metrics::Scrape, listening on loopback only
+class MetricsServer
+{
+public:
+    MetricsServer(asio::io_context& io_context, const unsigned short port);
+
+private:
+    void start_accept();
+    void handle_accept(const asio::error_code& ec);
+
+private:
+    asio::io_context& io_context_;
+    asio::ip::tcp::acceptor acceptor_;
+    asio::ip::tcp::socket next_socket_;
+};
@@ -1,27 +1,57 @@
 #pragma once
 
 #include <asio.hpp>
+#include <atomic>
 #include <deque>
 #include <vector>
 #include <mutex>
 
 #include <protocolCraft/Handler.hpp>
 
+#include "sniffcraft/AdmissionControl.hpp"
+#include "sniffcraft/Compression.hpp"
+#include "sniffcraft/Configuration.hpp"
 #include "sniffcraft/enums.hpp"
-#include "sniffcraft/Logger.hpp"
+#include "sniffcraft/FrameScanner.hpp"
+#include "sniffcraft/HostRouter.hpp"
+#include "sniffcraft/LatencyStats.hpp"
+#include "sniffcraft/PacketDecoder.hpp"
+#include "sniffcraft/TimerWheel.hpp"
+
+class ConfigWatcher;
 
 #define MAX_LENGTH 1024
 
 class MinecraftProxy : public ProtocolCraft::Handler
 {
 public:
-    MinecraftProxy(asio::io_context& io_context, const std::string &logconf_path);
-    void Start(const std::string& server_address, const unsigned short server_port);
+    // If decode_pool is not nullptr, Play packets are forwarded as soon
+    // as they are complete, and decoded/logged on the pool afterwards.
+    // If host_router is not nullptr, the connection to the server is
+    // delayed until the Handshake tells which server the client wants.
+    // timer_wheel must run on io_context, it tracks the session timeouts.
+    // If admission_control is not nullptr, the connection has been admitted
+    // before Start and is released when the session is closed.
+    // client_socket is the accepted connection, opened on io_context.
+    // The session log is written by logger_service
+    MinecraftProxy(asio::io_context& io_context, asio::ip::tcp::socket client_socket, const ConfigWatcher& config_watcher,
+        asio::thread_pool* decode_pool, const HostRouter* host_router, TimerWheel* timer_wheel, AdmissionControl* admission_control,
+        LoggerService& logger_service);
+    void Start(const std::string& server_address, const unsigned short server_port, const asio::ip::address& client_address);
+    // Close the sockets, the proxy deletes itself once
+    // the handlers of its pending operations have run
     void Close();
     asio::ip::tcp::socket& ClientSocket();
     asio::ip::tcp::socket& ServerSocket();
 
 private:
+    // Must be called first in each asio handler. Returns true if the
+    // proxy is closed: the handler must return right away, as the proxy
+    // may have been deleted
+    const bool FinishOperation();
+
+    void ConnectToServer();
+    void handle_server_resolve(const asio::error_code& ec, const std::vector<asio::ip::tcp::endpoint>& endpoints);
     void handle_server_connect(const asio::error_code &ec);
 
     void handle_server_read(const asio::error_code& ec, const size_t& bytes_transferred);
@@ -30,10 +60,37 @@ private:
     void handle_client_read(const asio::error_code& ec, const size_t& bytes_transferred);
     void handle_server_write(const asio::error_code& ec);
 
-    void ExtractPacketFromIncomingData(const Origin from, const size_t& bytes_transferred);
-    void ParsePacket(const Origin from, std::vector<unsigned char>::const_iterator& read_iter, size_t& max_length);
-
-    const std::vector<unsigned char> PacketToBytes(const ProtocolCraft::Message& msg);
+    // Returns false if the session must be closed (client
+    // data that can't be sent to any server)
+    const bool ExtractPacketFromIncomingData(const Origin from, const size_t& bytes_transferred, const std::chrono::steady_clock::time_point& read_time);
+    // Swap the pending bytes for dst with its write buffer and
+    // start writing them, if nothing is being written yet.
+    // output mutex for dst must be locked
+    void StartWrite(const Origin dst);
+
+#ifdef __linux__
+    // Kernel passthrough, only used once in Play state if nothing
+    // has to be logged (all Play packets ignored, no stats)
+    const bool CanSplice() const;
+    // Forward what is left of the incoming data of this direction,
+    // and start splicing once it's written. Returns false if the
+    // passthrough can't be set up (normal reads should continue)
+    const bool StartSplice(const Origin from);
+    // Move as much data as possible from src to dst socket through the pipe
+    void SpliceStep(const Origin from);
+    void handle_splice_wait(const Origin from, const asio::error_code& ec);
+#endif
+
+    // Schedule the timeout entry at the closest deadline
+    void ScheduleTimeout();
+    void handle_timeout();
+
+    // Record the timings of the packet just written to dst
+    void RecordWrittenPacket(const Origin dst);
+    void DumpLatencyStats();
+
+    // Serialize msg as a complete packet (length, compression) at the end of output
+    void PacketToBytes(const ProtocolCraft::Message& msg, std::vector<unsigned char>& output);
 
 private:
     virtual void Handle(ProtocolCraft::Message& msg) override;
@@ -44,6 +101,7 @@ private:
 
 private:
     asio::io_context& io_context_;
+    const ConfigWatcher& config_watcher_;
 
     asio::ip::tcp::socket client_socket_;
     std::array<unsigned char, MAX_LENGTH> input_client_buffer_;
@@ -51,25 +109,95 @@ private:
     std::array<unsigned char, MAX_LENGTH> input_server_buffer_;
     bool client_closed;
     bool server_closed;
-
-    std::deque<std::vector<unsigned char> > output_client_data_;
+    // Asynchronous operations started and whose handler has not run yet
+    std::atomic<unsigned int> pending_operations_;
+    // Nothing is written to the server before that
+    bool server_connected_;
+
+    const HostRouter* host_router_;
+
+    AdmissionControl* admission_control_;
+    asio::ip::address client_address_;
+
+    // nullptr if all the timeouts are disabled
+    TimerWheel* timer_wheel_;
+    TimerWheel::Entry timeout_entry_;
+    // In wheel ticks, 0 if disabled
+    unsigned long long handshake_timeout_ticks_;
+    unsigned long long login_timeout_ticks_;
+    unsigned long long idle_timeout_ticks_;
+    // Deadline of the handshake or login, 0 once in Play
+    unsigned long long phase_deadline_;
+    // Tick of the last read on either side, the idle
+    // deadline is only checked when the entry fires
+    unsigned long long last_activity_;
+
+    // Applied on accept/connect
+    SocketOptions client_socket_options_;
+    SocketOptions server_socket_options_;
+
+    // Forwarded packets are appended to output_*_data_ while
+    // output_*_buffer_ is being written, then the two are swapped.
+    // Both keep their capacity, so forwarding doesn't allocate
+    std::vector<unsigned char> output_client_data_;
     std::mutex output_client_mutex_;
     std::vector<unsigned char> output_client_buffer_;
-    std::deque<std::vector<unsigned char> > output_server_data_;
+    std::vector<unsigned char> output_server_data_;
     std::mutex output_server_mutex_;
     std::vector<unsigned char> output_server_buffer_;
+    // Number of packets in each of the buffers above
+    size_t output_client_data_packets_;
+    size_t output_client_buffer_packets_;
+    size_t output_server_data_packets_;
+    size_t output_server_buffer_packets_;
+
+    // Latency instrumentation, only allocated if enabled when the session starts.
+    // Timings are pushed and popped along with the output data (same mutex)
+    std::unique_ptr<LatencyStats> latency_stats_;
+    // What has been recorded since the last merge into the global stats
+    std::unique_ptr<LatencyStats> latency_stats_delta_;
+    std::deque<PacketTiming> output_client_timings_;
+    std::deque<PacketTiming> output_server_timings_;
+    std::chrono::steady_clock::time_point last_latency_dump_;
+    std::chrono::seconds latency_dump_interval_;
+    size_t latency_top_packets_;
 
     std::vector<unsigned char> input_client_data_;
     std::vector<unsigned char> input_server_data;
+    // Complete packets found in the input data, reused for each read
+    std::vector<FrameSpan> client_frame_spans;
+    std::vector<FrameSpan> server_frame_spans;
 
     ProtocolCraft::ConnectionState connection_state;
 
     std::vector<unsigned char> client_replacement_data;
     std::vector<unsigned char> server_replacement_data;
+    // Reused by PacketToBytes, they keep their capacity
+    std::vector<unsigned char> packet_write_buffer_;
+    std::vector<unsigned char> packet_compress_buffer_;
+    // Only created the first time a rewritten packet has to be compressed
+    std::unique_ptr<Compressor> compressor_;
 
     int compression_threshold;
 
-    Logger logger;
+#ifdef __linux__
+    struct SpliceLeg
+    {
+        int pipe_fds[2];
+        // Bytes in the pipe, not yet written to dst
+        size_t in_pipe;
+        // Waiting for the output buffers to be written
+        bool pending;
+    };
+    // Decided when switching to Play state
+    bool splice_enabled_;
+    // Indexed by Origin
+    SpliceLeg splice_legs_[2];
+#endif
+
+    const unsigned long long session_id;
+    // Shared with the batches waiting on the decode pool
+    std::shared_ptr<PacketDecoder> decoder;
     std::string server_ip_;
     unsigned short server_port_;
 };
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <asio.hpp>
+
+#include <protocolCraft/enums.hpp>
+#include <protocolCraft/Handler.hpp>
+#include <protocolCraft/Message.hpp>
+
+#include "sniffcraft/Configuration.hpp"
+#include "sniffcraft/enums.hpp"
+#include "sniffcraft/FrameScanner.hpp"
+#include "sniffcraft/Logger.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class ConfigWatcher;
+
+// Packets of one read to decode on the pool
+struct DecodeBatch
+{
+    Origin origin;
+    ProtocolCraft::ConnectionState connection_state;
+    int compression_threshold;
+    // Copy of the frames, spans are relative to this data
+    std::vector<unsigned char> data;
+    std::vector<FrameSpan> spans;
+};
+
+// Decompress, read and log the packets of one session. Owned
+// through a shared_ptr, so batches still waiting on the decode
+// pool keep it (and the logger) alive after the session is closed
+class PacketDecoder : public std::enable_shared_from_this<PacketDecoder>
+{
+public:
+    // If decode_pool is nullptr, everything is decoded inline.
+    // Logged packets are written by logger_service
+    PacketDecoder(const ConfigWatcher& config_watcher, const unsigned long long session_id, asio::thread_pool* decode_pool,
+        LoggerService& logger_service);
+    // Only stops the logger, its queue is written in the background
+    ~PacketDecoder();
+
+    Logger& GetLogger();
+    const bool HasDecodePool() const;
+
+    // Decode one packet (read_iter is after the packet length) and log it.
+    // If handler is not nullptr, the message is dispatched to it before
+    // being logged with connection_state (that the handler may change).
+    // Returns the packet id, -1 if it can't be read
+    const int Decode(const Origin from, const ProtocolCraft::ConnectionState& connection_state, const int compression_threshold,
+        std::vector<unsigned char>::const_iterator& read_iter, size_t& max_length, const size_t wire_size,
+        ProtocolCraft::Handler* handler);
+
+    // Decode and log a batch on the pool. Batches of a session are
+    // decoded one after the other, in the order they are queued.
+    // If the pool is too far behind, the batch is dropped (the packets
+    // are already forwarded) and counted, see MAX_QUEUED_DECODE_BYTES
+    void DecodeAsync(const std::shared_ptr<DecodeBatch>& batch);
+
+private:
+    void DecodeBatchNow(DecodeBatch& batch);
+
+    // Refresh configuration if a new version has been published
+    void UpdateConfiguration();
+
+    // Take a message given back by the logger for this packet, or create one.
+    // Its fields are overwritten when the packet is read, optional ones not
+    // present in the new packet are only hidden by their presence flag
+    std::shared_ptr<ProtocolCraft::Message> GetPooledMessage(const Origin from, const ProtocolCraft::ConnectionState connection_state, const int id);
+
+private:
+    std::shared_ptr<Logger> logger;
+
+    const ConfigWatcher& config_watcher;
+
+    // Only set if decoding is done on a pool
+    std::unique_ptr<asio::strand<asio::thread_pool::executor_type> > decode_strand;
+
+    // Decode is never called concurrently: packets are decoded inline
+    // until the Play state and only on the strand after that, so no
+    // lock is needed for these
+    // Snapshot of the configuration, to skip ignored packets without
+    // locking anything, refreshed from config_watcher
+    std::shared_ptr<const Configuration> configuration;
+    unsigned int configuration_version;
+    // Free messages per origin/state/id, see GetPooledMessage
+    std::vector<std::vector<std::shared_ptr<ProtocolCraft::Message> > > message_pool;
+    // Reused to take the messages released by the logger
+    std::vector<ReleasedMessage> released_messages;
+    // Bytes of the batches posted on the pool and not decoded yet
+    std::atomic<size_t> queued_decode_bytes;
+    // Packets dropped since the last batch decoded, reported in the log
+    std::atomic<unsigned long long> dropped_decode_packets;
+
+    // Reused for all the compressed packets, only grows
+    std::vector<unsigned char> client_decompressed_data;
+    std::vector<unsigned char> server_decompressed_data;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "sniffcraft/enums.hpp"
+
+#include <protocolCraft/enums.hpp>
+
+#include <string>
+#include <vector>
+
+// Per (direction, state, id) packet counters, stored in flat arrays
+// so recording a packet is only a few additions
+class PacketStats
+{
+public:
+    PacketStats();
+
+    // wire_size is the size of the frame as received (length prefix included),
+    // uncompressed_size the size of the packet id and data once decompressed
+    void Record(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id,
+        const size_t wire_size, const size_t uncompressed_size);
+    const bool IsEmpty() const;
+
+    // Table of the top_n packet types with the most bytes on the wire
+    const std::string ToString(const size_t top_n) const;
+
+private:
+    static const int MAX_ID = 256;
+    static const int NUM_STATE = 4;
+    static const int NUM_ENTRIES = 2 * NUM_STATE * MAX_ID;
+    // Bucket i counts packets with a wire size in [2^(i+3), 2^(i+4)[,
+    // first and last buckets also count everything below/above
+    static const int NUM_SIZE_BUCKETS = 16;
+
+    static const int Index(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id);
+    static const int SizeBucket(const size_t size);
+
+private:
+    std::vector<unsigned long long> counts;
+    std::vector<unsigned long long> wire_bytes;
+    std::vector<unsigned long long> uncompressed_bytes;
+    // NUM_SIZE_BUCKETS consecutive buckets for each entry
+    std::vector<unsigned int> size_histograms;
+    unsigned long long total_count;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+enum class ProfileStage
+{
+    Framing = 0,
+    Decompression,
+    MessageCreation,
+    MessageRead,
+    MessageDispatch,
+    PacketToBytes,
+    LogFormatting,
+    NUM_PROFILE_STAGE
+};
+
+// Time spent in the hot path stages. Each thread accumulates in
+// its own slot, slots are only summed when the summary is asked.
+// Use the SNIFFCRAFT_PROFILE_SCOPE macro so everything disappears
+// when SNIFFCRAFT_PROFILING is OFF in CMake
+class Profiler
+{
+public:
+    static void Add(const ProfileStage stage, const unsigned long long nanoseconds);
+
+    // Calls, total and mean time per stage, over all threads
+    static const std::string Summary();
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(const ProfileStage stage_) : stage(stage_), start(std::chrono::steady_clock::now())
+    {
+
+    }
+
+    ~ProfileScope()
+    {
+        Profiler::Add(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    const ProfileStage stage;
+    const std::chrono::steady_clock::time_point start;
+};
+
+#define SNIFFCRAFT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SNIFFCRAFT_PROFILE_CONCAT(a, b) SNIFFCRAFT_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef SNIFFCRAFT_PROFILING
+#define SNIFFCRAFT_PROFILE_SCOPE(stage) ProfileScope SNIFFCRAFT_PROFILE_CONCAT(profile_scope_, __LINE__)(stage)
+#else
+#define SNIFFCRAFT_PROFILE_SCOPE(stage)
+#endif
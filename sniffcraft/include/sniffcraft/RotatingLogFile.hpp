@@ -0,0 +1,50 @@
+#pragma once
+
+#include "sniffcraft/Configuration.hpp"
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <string>
+
+// Session log file split in segments by size and/or duration.
+// Finished segments are optionally gzipped by the BackgroundCompressor
+// and only the last max_segments ones are kept on disk
+class RotatingLogFile
+{
+public:
+    RotatingLogFile();
+    ~RotatingLogFile();
+
+    // Files are named <name_prefix>[_<segment>]<extension> in the conf log directory
+    void Open(const std::string& name_prefix, const std::string& extension_, const Configuration& conf);
+    const bool IsOpen() const;
+    void Close();
+
+    // Append line and a new line character
+    void WriteLine(const std::string& line);
+    // Flush the current segment and start a new one if it's too old
+    void Flush();
+
+private:
+    const std::string SegmentPath(const size_t index) const;
+    void OpenSegment();
+    void CloseSegment();
+
+private:
+    std::ofstream file;
+
+    std::string base_path;
+    std::string extension;
+    bool rotation_enabled;
+    unsigned long long max_segment_size;
+    std::chrono::seconds max_segment_duration;
+    bool compress;
+    size_t max_segments;
+
+    size_t segment_index;
+    unsigned long long segment_size;
+    std::chrono::steady_clock::time_point segment_start;
+    // Paths of the closed segments still on disk (before compression)
+    std::deque<std::string> finished_segments;
+};
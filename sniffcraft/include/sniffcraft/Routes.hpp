@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// One listening port forwarded to one server
+struct Route
+{
+    unsigned short listen_port;
+    std::string server_address;
+    // Can be empty
+    std::string logconf_path;
+    // Hostname asked by the client in its Handshake -> server address.
+    // If not empty, server_address is only used for unknown hostnames
+    std::vector<std::pair<std::string, std::string> > hosts;
+};
+
+// Read the routes of a routes file, throws if the file
+// can't be read or if a route is invalid
+const std::vector<Route> LoadRoutes(const std::string& path);
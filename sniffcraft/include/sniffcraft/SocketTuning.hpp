@@ -0,0 +1,13 @@
+#pragma once
+
+#include <asio.hpp>
+
+#include "sniffcraft/Configuration.hpp"
+
+// Set the options on a connected socket. Options not supported
+// by the platform are skipped, failures are only reported
+void ApplySocketOptions(asio::ip::tcp::socket& socket, const SocketOptions& options, const std::string& leg_name);
+
+// TCP_QUICKACK is not permanent, it has to be set again after each read.
+// Does nothing outside of Linux
+void RearmQuickAck(asio::ip::tcp::socket& socket);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// One instance of Shard per thread, written by its thread without
+// locking and read by an aggregator. Shards are never freed: those of
+// finished threads are given to new ones and keep their values, as
+// they are only summed nothing is lost
+template<class Shard>
+class ThreadShards
+{
+public:
+    // Shard of the calling thread
+    static Shard& Local()
+    {
+        thread_local Handle handle;
+        return *handle.shard;
+    }
+
+    // Call function(const Shard&) on all the shards ever
+    // created, under the registry lock. Returns their number
+    template<class Function>
+    static const size_t ForEach(Function function)
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t i = 0; i < registry.shards.size(); ++i)
+        {
+            function(static_cast<const Shard&>(*registry.shards[i]));
+        }
+        return registry.shards.size();
+    }
+
+private:
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Shard> > shards;
+        std::vector<Shard*> free_shards;
+    };
+
+    static Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Takes a shard when the thread first uses it, gives it back on exit
+    class Handle
+    {
+    public:
+        Handle()
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            if (!registry.free_shards.empty())
+            {
+                shard = registry.free_shards.back();
+                registry.free_shards.pop_back();
+            }
+            else
+            {
+                registry.shards.push_back(std::unique_ptr<Shard>(new Shard()));
+                shard = registry.shards.back().get();
+            }
+        }
+
+        ~Handle()
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.free_shards.push_back(shard);
+        }
+
+        Shard* shard;
+    };
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <asio.hpp>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// Coarse timeouts for many sessions with only one steady_timer.
+// Entries are hashed by deadline tick into a ring of slots, each
+// tick only looks at one slot. Not thread safe, all the methods must
+// be called from the thread running the io_context of the wheel
+class TimerWheel
+{
+public:
+    // Intrusive node, usually a member of the object to time out
+    struct Entry
+    {
+        Entry();
+
+        // Called from the wheel once the deadline is reached,
+        // the entry is not scheduled anymore at this point
+        std::function<void()> callback;
+
+        unsigned long long deadline;
+        Entry* prev;
+        Entry* next;
+        bool scheduled;
+    };
+
+    TimerWheel(asio::io_context& io_context, const std::chrono::milliseconds& tick_duration, const size_t num_slots);
+
+    // (Re)schedule entry to fire at deadline (in ticks, see CurrentTick)
+    void Schedule(Entry& entry, const unsigned long long deadline);
+    void Cancel(Entry& entry);
+
+    // Updated once per tick while entries are scheduled,
+    // cheap enough to be read on each socket read
+    const unsigned long long CurrentTick() const;
+    // Number of ticks in duration, rounded up
+    const unsigned long long Ticks(const std::chrono::milliseconds& duration) const;
+
+private:
+    void StartTimer();
+    void handle_tick(const asio::error_code& ec);
+    // Tick the wheel would be at now
+    const unsigned long long ElapsedTicks() const;
+
+private:
+    asio::steady_timer timer_;
+    const std::chrono::milliseconds tick_duration_;
+    const std::chrono::steady_clock::time_point start_time_;
+
+    // Head of the list of each slot
+    std::vector<Entry*> slots_;
+    unsigned long long current_tick_;
+    size_t num_entries_;
+    bool timer_running_;
+
+    // Entries expired during the current tick, reused
+    std::vector<Entry*> expired_;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "sniffcraft/enums.hpp"
+
+#include <chrono>
+#include <cstddef>
+
+// Write log timestamps into char buffers. The part of the
+// timestamp that only changes every second is cached, so
+// most calls only have to write the milliseconds digits
+class TimestampFormatter
+{
+public:
+    // Enough for any of the formats
+    static const size_t MAX_LENGTH = 32;
+
+    TimestampFormatter();
+
+    // Reference time for TimestampFormat::Relative
+    void SetStartTime(const std::chrono::system_clock::time_point& start_time_);
+
+    // Write the timestamp into output (at least MAX_LENGTH chars,
+    // not null terminated) and return the number of chars written
+    const size_t Format(const TimestampFormat format,
+        const std::chrono::system_clock::time_point& date,
+        const std::chrono::steady_clock::time_point& monotonic_date,
+        char* output);
+
+private:
+    const size_t FormatRelative(const std::chrono::system_clock::time_point& date, char* output);
+    const size_t FormatAbsolute(const std::chrono::system_clock::time_point& date, char* output);
+    const size_t FormatMonotonic(const std::chrono::steady_clock::time_point& monotonic_date, char* output);
+
+private:
+    std::chrono::system_clock::time_point start_time;
+
+    // Everything before the milliseconds for cached_second
+    TimestampFormat cached_format;
+    long long cached_second;
+    char cached_prefix[MAX_LENGTH];
+    size_t cached_prefix_length;
+};
@@ -5,3 +5,34 @@ enum class Origin
     Server,
     Client
 };
+
+// What to do when a Logger queue is full
+enum class LogOverflowPolicy
+{
+    Block,              // Wait until the logging thread makes room
+    DropNewest,         // Discard incoming items
+    DropDetailedFirst,  // Log details only below high watermark, then discard
+    Sample              // Keep one item every sample_rate above high watermark, then discard
+};
+
+// What is written in the session log
+enum class LogMode
+{
+    Packets,    // Each packet (name or details) according to the filters
+    Stats       // Only periodic per packet type traffic stats
+};
+
+// How packets are written in the logs
+enum class LogFormat
+{
+    Text,       // Human readable lines, details as indented JSON
+    JsonLines   // One JSON object per line
+};
+
+// How timestamps are written in the logs
+enum class TimestampFormat
+{
+    Relative,   // hh:mm:ss:mmm since the beginning of the session
+    Absolute,   // ISO 8601 UTC date with milliseconds
+    Monotonic   // Nanoseconds of the steady clock, comparable between sessions
+};
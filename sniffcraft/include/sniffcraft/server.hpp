@@ -2,26 +2,93 @@
 
 #include <asio.hpp>
 
+#include "sniffcraft/AdmissionControl.hpp"
+#include "sniffcraft/ConfigWatcher.hpp"
+#include "sniffcraft/HostRouter.hpp"
+#include "sniffcraft/LoggerService.hpp"
+#include "sniffcraft/MetricsServer.hpp"
+#include "sniffcraft/Routes.hpp"
+#include "sniffcraft/TimerWheel.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
 class MinecraftProxy;
 
 class Server
 {
 public:
-    Server(asio::io_context& io_context, const unsigned short client_port,
-        const std::string& server_address, const std::string& logconf_path_);
+    // Settings read at startup (workers, metrics, decode threads...)
+    // come from the conf of the first route
+    Server(asio::io_context& io_context, const std::vector<Route>& routes);
+    ~Server();
 
 private:
-    void start_accept();
-    void handle_accept(MinecraftProxy* new_proxy, const asio::error_code &ec);
-    void ResolveIpPortFromAddress(const std::string& address);
+    // Everything needed to accept the sessions of one route
+    struct Listener
+    {
+        unsigned short listen_port;
+        std::string server_ip;
+        unsigned short server_port;
+        std::unique_ptr<ConfigWatcher> config_watcher;
+        // Only if the route has hosts
+        std::unique_ptr<HostRouter> host_router;
+        // With reuse_port, one per worker (bound to the same port) and the
+        // kernel spreads the connections, otherwise only one on io_context_
+        std::vector<std::unique_ptr<asio::ip::tcp::acceptor> > acceptors;
+    };
+
+    // Create the contexts of the additional workers
+    void CreateWorkers(const Configuration& conf);
+    // Open the listening socket(s) of a route
+    void StartListening(Listener& listener, const Configuration& conf);
+    void start_accept(Listener* listener, const size_t acceptor_index);
+    void handle_accept(Listener* listener, const size_t acceptor_index, const size_t worker, const asio::error_code& ec, asio::ip::tcp::socket client_socket);
+    void ResolveIpPortFromAddress(const std::string& address, std::string& server_ip, unsigned short& server_port);
+    void StartLatencyTimer();
+    void handle_latency_timer(const asio::error_code& ec);
+    void WaitShutdownSignal();
+    void handle_shutdown_signal(const asio::error_code& ec, int signal_number);
+#if defined(SNIFFCRAFT_PROFILING) && !defined(_WIN32)
+    void WaitProfilerSignal();
+    void handle_profiler_signal(const asio::error_code& ec, int signal_number);
+#endif
     
 private:
     asio::io_context& io_context_;
-    asio::ip::tcp::acceptor acceptor_;
+    // Contexts of the additional workers, each run by its own thread.
+    // Sessions are spread on io_context_ and these ones
+    std::vector<std::unique_ptr<asio::io_context> > worker_contexts_;
+    std::vector<asio::executor_work_guard<asio::io_context::executor_type> > worker_guards_;
+    std::vector<std::thread> worker_threads_;
+    // Session timeouts, one per context (io_context_ first, then the workers)
+    std::vector<std::unique_ptr<TimerWheel> > timer_wheels_;
+    // Round robin on the workers when a route has only one acceptor
+    size_t next_worker_;
+    bool reuse_port_enabled_;
+    // Periodically dump the global latency stats
+    asio::steady_timer latency_timer_;
+    // SIGINT and SIGTERM stop io_context_, so the server is
+    // destroyed and the session logs are written before exiting
+    asio::signal_set shutdown_signals_;
+#if defined(SNIFFCRAFT_PROFILING) && !defined(_WIN32)
+    // SIGUSR1 prints the profiler summary
+    asio::signal_set profiler_signals_;
+#endif
 
-    std::string server_ip_;
-    unsigned short server_port_;
+    // One per route, the first one is used for the process settings
+    std::vector<std::unique_ptr<Listener> > listeners_;
 
-    std::string logconf_path;
-};
+    // Only created if enabled in the conf at startup
+    std::unique_ptr<MetricsServer> metrics_server_;
 
+    // Only created if a limit is set in the Admission section at startup
+    std::unique_ptr<AdmissionControl> admission_control_;
+
+    // Shared by all the sessions, only created if DecodeThreads > 0 at startup
+    std::unique_ptr<asio::thread_pool> decode_pool_;
+
+    // Writes the session logs of all the routes, LogThreads threads read at startup
+    std::unique_ptr<LoggerService> logger_service_;
+};
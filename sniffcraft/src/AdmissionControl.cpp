@@ -0,0 +1,183 @@
+#include "sniffcraft/AdmissionControl.hpp"
+
+#include <algorithm>
+#include <functional>
+
+// Minimum number of IPs in a stripe before trying to remove some
+const size_t MIN_CLEANUP_SIZE = 64;
+
+AdmissionControl::AdmissionControl(const Configuration& conf) :
+    max_connections_(conf.admission_max_connections),
+    max_connections_per_ip_(conf.admission_max_connections_per_ip),
+    rate_(conf.admission_rate),
+    burst_(conf.admission_burst > 1.0 ? conf.admission_burst : 1.0),
+    rate_per_ip_(conf.admission_rate_per_ip),
+    burst_per_ip_(conf.admission_burst_per_ip > 1.0 ? conf.admission_burst_per_ip : 1.0),
+    active_connections_(0)
+{
+    global_bucket_.tokens = burst_;
+    global_bucket_.last_refill = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < stripes_.size(); ++i)
+    {
+        stripes_[i].cleanup_size = MIN_CLEANUP_SIZE;
+    }
+}
+
+const bool AdmissionControl::TryAdmit(const asio::ip::address& address)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (max_connections_per_ip_ == 0 && rate_per_ip_ == 0.0)
+    {
+        return TryAdmitGlobal(now);
+    }
+
+    // Per IP limits are checked first, so a flooding IP
+    // doesn't use the global tokens of the others
+    const IpKey key = MakeKey(address);
+    Stripe& stripe = GetStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.states.find(key);
+    if (it == stripe.states.end())
+    {
+        if (stripe.states.size() >= stripe.cleanup_size)
+        {
+            Cleanup(stripe, now);
+        }
+        IpState state;
+        state.active = 0;
+        state.bucket.tokens = burst_per_ip_;
+        state.bucket.last_refill = now;
+        it = stripe.states.insert({ key, state }).first;
+    }
+
+    if (max_connections_per_ip_ > 0 && it->second.active >= max_connections_per_ip_)
+    {
+        return false;
+    }
+    if (!TakeToken(it->second.bucket, rate_per_ip_, burst_per_ip_, now))
+    {
+        return false;
+    }
+    if (!TryAdmitGlobal(now))
+    {
+        // Not this IP's fault, give its token back so it
+        // isn't locked out once the global overload is over
+        if (rate_per_ip_ > 0.0)
+        {
+            it->second.bucket.tokens += 1.0;
+        }
+        return false;
+    }
+    it->second.active += 1;
+    return true;
+}
+
+void AdmissionControl::Release(const asio::ip::address& address)
+{
+    active_connections_.fetch_sub(1, std::memory_order_relaxed);
+
+    if (max_connections_per_ip_ == 0 && rate_per_ip_ == 0.0)
+    {
+        return;
+    }
+
+    const IpKey key = MakeKey(address);
+    Stripe& stripe = GetStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.states.find(key);
+    if (it != stripe.states.end() && it->second.active > 0)
+    {
+        // Kept for its bucket, removed by the next cleanup
+        it->second.active -= 1;
+    }
+}
+
+bool AdmissionControl::IpKey::operator==(const IpKey& other) const
+{
+    return high == other.high && low == other.low;
+}
+
+size_t AdmissionControl::IpKeyHash::operator()(const IpKey& key) const
+{
+    return std::hash<unsigned long long>()(key.high * 0x9E3779B97F4A7C15ULL ^ key.low);
+}
+
+const AdmissionControl::IpKey AdmissionControl::MakeKey(const asio::ip::address& address)
+{
+    const asio::ip::address_v6::bytes_type bytes = address.is_v4() ?
+        asio::ip::make_address_v6(asio::ip::v4_mapped, address.to_v4()).to_bytes() :
+        address.to_v6().to_bytes();
+
+    IpKey key;
+    key.high = 0;
+    key.low = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        key.high = (key.high << 8) | bytes[i];
+        key.low = (key.low << 8) | bytes[i + 8];
+    }
+    return key;
+}
+
+AdmissionControl::Stripe& AdmissionControl::GetStripe(const IpKey& key)
+{
+    return stripes_[IpKeyHash()(key) % NUM_STRIPES];
+}
+
+const bool AdmissionControl::TryAdmitGlobal(const std::chrono::steady_clock::time_point& now)
+{
+    const unsigned int active = active_connections_.fetch_add(1, std::memory_order_relaxed);
+    if (max_connections_ > 0 && active >= max_connections_)
+    {
+        active_connections_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (rate_ > 0.0)
+    {
+        std::lock_guard<std::mutex> lock(global_bucket_mutex_);
+        if (!TakeToken(global_bucket_, rate_, burst_, now))
+        {
+            active_connections_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+const bool AdmissionControl::TakeToken(TokenBucket& bucket, const double rate, const double burst, const std::chrono::steady_clock::time_point& now) const
+{
+    if (rate == 0.0)
+    {
+        return true;
+    }
+
+    const double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+    bucket.tokens = std::min(burst, bucket.tokens + elapsed * rate);
+    bucket.last_refill = now;
+    if (bucket.tokens < 1.0)
+    {
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+void AdmissionControl::Cleanup(Stripe& stripe, const std::chrono::steady_clock::time_point& now)
+{
+    for (auto it = stripe.states.begin(); it != stripe.states.end(); )
+    {
+        const bool full_bucket = rate_per_ip_ == 0.0 ||
+            it->second.bucket.tokens + std::chrono::duration<double>(now - it->second.bucket.last_refill).count() * rate_per_ip_ >= burst_per_ip_;
+        if (it->second.active == 0 && full_bucket)
+        {
+            it = stripe.states.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    stripe.cleanup_size = std::max(MIN_CLEANUP_SIZE, 2 * stripe.states.size());
+}
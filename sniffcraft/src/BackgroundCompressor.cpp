@@ -0,0 +1,123 @@
+#include "sniffcraft/BackgroundCompressor.hpp"
+
+#include <zlib.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+BackgroundCompressor& BackgroundCompressor::GetInstance()
+{
+    static BackgroundCompressor instance;
+    return instance;
+}
+
+BackgroundCompressor::BackgroundCompressor()
+{
+    is_running = true;
+    worker_thread = std::thread(&BackgroundCompressor::WorkLoop, this);
+}
+
+BackgroundCompressor::~BackgroundCompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        is_running = false;
+    }
+    jobs_condition.notify_all();
+
+    // Pending jobs are done before returning
+    if (worker_thread.joinable())
+    {
+        worker_thread.join();
+    }
+}
+
+void BackgroundCompressor::Compress(const std::string& path)
+{
+    Push(path, true);
+}
+
+void BackgroundCompressor::Remove(const std::string& path)
+{
+    Push(path, false);
+}
+
+void BackgroundCompressor::Push(const std::string& path, const bool compress)
+{
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        jobs.push_back({ path, compress });
+    }
+    jobs_condition.notify_one();
+}
+
+void BackgroundCompressor::WorkLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex);
+            jobs_condition.wait(lock, [this] { return !is_running || !jobs.empty(); });
+            if (jobs.empty())
+            {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        if (job.compress)
+        {
+            CompressFile(job.path);
+        }
+        else
+        {
+            std::remove(job.path.c_str());
+            std::remove((job.path + ".gz").c_str());
+        }
+    }
+}
+
+void BackgroundCompressor::CompressFile(const std::string& path)
+{
+    std::ifstream input(path, std::ios::in | std::ios::binary);
+    if (!input.is_open())
+    {
+        std::cerr << "Error trying to open " << path << " for compression" << std::endl;
+        return;
+    }
+
+    const std::string output_path = path + ".gz";
+    gzFile output = gzopen(output_path.c_str(), "wb6");
+    if (output == NULL)
+    {
+        std::cerr << "Error trying to create " << output_path << std::endl;
+        return;
+    }
+
+    std::vector<char> buffer(256 * 1024);
+    bool error = false;
+    while (input)
+    {
+        input.read(buffer.data(), buffer.size());
+        const std::streamsize read = input.gcount();
+        if (read > 0 && gzwrite(output, buffer.data(), static_cast<unsigned int>(read)) != read)
+        {
+            error = true;
+            break;
+        }
+    }
+    input.close();
+
+    if (gzclose(output) != Z_OK || error)
+    {
+        std::cerr << "Error compressing " << path << ", keeping uncompressed file" << std::endl;
+        std::remove(output_path.c_str());
+        return;
+    }
+
+    std::remove(path.c_str());
+}
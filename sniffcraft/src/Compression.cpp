@@ -7,42 +7,107 @@
 
 const unsigned long MAX_COMPRESSED_PACKET_LEN = 200 * 1024;
 
-std::vector<unsigned char> Compress(const std::vector<unsigned char> &raw, const int &start, const int &size)
+Compressor::Compressor() :
+    stream_(nullptr)
 {
-    unsigned long size_to_compress = size > 0 ? size : raw.size() - start;
-    unsigned long compressedSize = compressBound(size_to_compress);
+
+}
+
+Compressor::~Compressor()
+{
+    if (stream_ != nullptr)
+    {
+        deflateEnd(stream_);
+        delete stream_;
+    }
+}
+
+void Compressor::Compress(const unsigned char* raw, const size_t size, std::vector<unsigned char>& output)
+{
+    if (stream_ == nullptr)
+    {
+        stream_ = new z_stream();
+        memset(stream_, 0, sizeof(z_stream));
+        // Same zlib format (window bits, memory) as compress2
+        if (deflateInit2(stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            delete stream_;
+            stream_ = nullptr;
+            throw(std::runtime_error("deflateInit2 failed"));
+        }
+    }
+    else
+    {
+        deflateReset(stream_);
+    }
+
+    unsigned long compressedSize = deflateBound(stream_, size);
 
     if (compressedSize > MAX_COMPRESSED_PACKET_LEN)
     {
         throw(std::runtime_error("Incoming packet is too big"));
     }
 
-    std::vector<unsigned char> compressedData(compressedSize);
-    int status = compress2(compressedData.data(), &compressedSize, raw.data() + start, size_to_compress, Z_DEFAULT_COMPRESSION);
+    // Compressed directly at the end of output, then shrunk to the real size
+    const size_t start = output.size();
+    output.resize(start + compressedSize);
+    stream_->next_in = const_cast<unsigned char*>(raw);
+    stream_->avail_in = static_cast<unsigned int>(size);
+    stream_->next_out = output.data() + start;
+    stream_->avail_out = static_cast<unsigned int>(compressedSize);
 
-    if (status != Z_OK)
+    // Output is big enough, everything is done in one call
+    if (deflate(stream_, Z_FINISH) != Z_STREAM_END)
     {
+        output.resize(start);
         throw(std::runtime_error("Error compressing packet"));
     }
 
-    return std::vector<unsigned char>(compressedData.begin(), compressedData.begin() + compressedSize);
+    output.resize(start + compressedSize - stream_->avail_out);
 }
 
-std::vector<unsigned char> Decompress(const std::vector<unsigned char>& compressed, const int& start, const int& size)
+void Decompress(const unsigned char* compressed, const size_t size, unsigned char* output, const size_t output_size)
 {
-    unsigned long size_to_decompress = size > 0 ? size : compressed.size() - start;
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    strm.next_in = const_cast<unsigned char*>(compressed);
+    strm.avail_in = size;
+    strm.next_out = output;
+    strm.avail_out = output_size;
 
-    std::vector<unsigned char> decompressedData;
-    decompressedData.reserve(size_to_decompress);
+    int res = inflateInit(&strm);
+    if (res != Z_OK)
+    {
+        throw(std::runtime_error("inflateInit failed: " + std::string(strm.msg)));
+    }
+
+    // Output is already the right size, everything is done in one call
+    res = inflate(&strm, Z_FINISH);
+    const size_t written = output_size - strm.avail_out;
+    inflateEnd(&strm);
 
-    std::vector<unsigned char> buffer(64 * 1024);
+    if (res == Z_BUF_ERROR && strm.avail_out == 0)
+    {
+        throw(std::runtime_error("Decompressed data are bigger than the declared size (" + std::to_string(output_size) + ")"));
+    }
+    if (res != Z_STREAM_END)
+    {
+        throw(std::runtime_error("Inflate decompression failed"));
+    }
+    if (written != output_size)
+    {
+        throw(std::runtime_error("Decompressed data size (" + std::to_string(written) + ") does not match the declared size (" + std::to_string(output_size) + ")"));
+    }
+}
 
+size_t DecompressPrefix(const unsigned char* compressed, const size_t size, unsigned char* output, const size_t output_size)
+{
     z_stream strm;
     memset(&strm, 0, sizeof(strm));
-    strm.next_in = const_cast<unsigned char*>(compressed.data() + start);
-    strm.avail_in = size_to_decompress;
-    strm.next_out = buffer.data();
-    strm.avail_out = buffer.size();
+    strm.next_in = const_cast<unsigned char*>(compressed);
+    strm.avail_in = size;
+    strm.next_out = output;
+    strm.avail_out = output_size;
 
     int res = inflateInit(&strm);
     if (res != Z_OK)
@@ -50,30 +115,15 @@ std::vector<unsigned char> Decompress(const std::vector<unsigned char>& compress
         throw(std::runtime_error("inflateInit failed: " + std::string(strm.msg)));
     }
 
-    for (;;)
+    // Stops as soon as output is full
+    res = inflate(&strm, Z_SYNC_FLUSH);
+    const size_t written = output_size - strm.avail_out;
+    inflateEnd(&strm);
+
+    if (res != Z_OK && res != Z_STREAM_END && res != Z_BUF_ERROR)
     {
-        res = inflate(&strm, Z_NO_FLUSH);
-        switch (res)
-        {
-        case Z_OK:
-            decompressedData.insert(decompressedData.end(), buffer.begin(), buffer.end() - strm.avail_out);
-            strm.next_out = buffer.data();
-            strm.avail_out = buffer.size();
-            if (strm.avail_in == 0)
-            {
-                inflateEnd(&strm);
-                return decompressedData;
-            }
-            break;
-        case Z_STREAM_END:
-            decompressedData.insert(decompressedData.end(), buffer.begin(), buffer.end() - strm.avail_out);
-            inflateEnd(&strm);
-            return decompressedData;
-            break;
-        default:
-            inflateEnd(&strm);
-            throw(std::runtime_error("Inflate decompression failed: " + std::string(strm.msg)));
-            break;
-        }
+        throw(std::runtime_error("Inflate decompression failed"));
     }
-}
\ No newline at end of file
+
+    return written;
+}
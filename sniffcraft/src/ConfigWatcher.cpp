@@ -0,0 +1,168 @@
+#include "sniffcraft/ConfigWatcher.hpp"
+#include "sniffcraft/FileUtilities.hpp"
+
+#include <iostream>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#endif
+
+// How often the file modification time is checked when inotify is not available
+const std::chrono::seconds CONF_POLLING_INTERVAL(5);
+#ifdef __linux__
+// How long we can block in poll before checking if we should stop
+const int INOTIFY_POLL_TIMEOUT_MS = 500;
+#endif
+
+ConfigWatcher::ConfigWatcher(const std::string& path)
+{
+    conf_path = path;
+    last_time_modified = -1;
+    version = 0;
+
+    std::atomic_store(&configuration, std::shared_ptr<const Configuration>(std::make_shared<Configuration>()));
+    Reload(false);
+
+    is_running = conf_path != "";
+    if (is_running)
+    {
+        watch_thread = std::thread(&ConfigWatcher::WatchLoop, this);
+    }
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex);
+        is_running = false;
+    }
+    watch_condition.notify_all();
+
+    if (watch_thread.joinable())
+    {
+        watch_thread.join();
+    }
+}
+
+std::shared_ptr<const Configuration> ConfigWatcher::GetConfiguration() const
+{
+    return std::atomic_load(&configuration);
+}
+
+const unsigned int ConfigWatcher::GetVersion() const
+{
+    return version.load(std::memory_order_acquire);
+}
+
+void ConfigWatcher::Reload(const bool force)
+{
+    const std::time_t modification_time = GetModifiedTimestamp(conf_path);
+    if (modification_time == -1 ||
+        (!force && modification_time == last_time_modified))
+    {
+        return;
+    }
+    last_time_modified = modification_time;
+
+    std::cout << "Loading updated conf file" << std::endl;
+    std::shared_ptr<const Configuration> new_configuration = LoadConfiguration(conf_path);
+
+    // Keep the previous one if the new file is invalid
+    if (new_configuration == nullptr)
+    {
+        return;
+    }
+
+    std::atomic_store(&configuration, new_configuration);
+    version.fetch_add(1, std::memory_order_release);
+}
+
+void ConfigWatcher::WatchLoop()
+{
+#ifdef __linux__
+    const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd != -1)
+    {
+        InotifyLoop(inotify_fd);
+        close(inotify_fd);
+        return;
+    }
+    std::cerr << "Can't initialize inotify, falling back to polling for conf file changes" << std::endl;
+#endif
+    PollingLoop();
+}
+
+#ifdef __linux__
+void ConfigWatcher::InotifyLoop(const int inotify_fd)
+{
+    // Watch the parent directory, as most editors replace
+    // the file instead of writing into it
+    const size_t separator = conf_path.find_last_of('/');
+    const std::string directory = separator == std::string::npos ? "." : (separator == 0 ? "/" : conf_path.substr(0, separator));
+    const std::string filename = separator == std::string::npos ? conf_path : conf_path.substr(separator + 1);
+
+    if (inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) == -1)
+    {
+        std::cerr << "Can't watch " << directory << " with inotify, falling back to polling for conf file changes" << std::endl;
+        PollingLoop();
+        return;
+    }
+
+    // Aligned as inotify_event, big enough for at least one event with the longest name
+    alignas(struct inotify_event) char buffer[sizeof(struct inotify_event) + NAME_MAX + 1];
+
+    pollfd poll_fd;
+    poll_fd.fd = inotify_fd;
+    poll_fd.events = POLLIN;
+
+    while (is_running)
+    {
+        poll_fd.revents = 0;
+        const int ready = poll(&poll_fd, 1, INOTIFY_POLL_TIMEOUT_MS);
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        bool conf_changed = false;
+        ssize_t len;
+        while ((len = read(inotify_fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* ptr = buffer; ptr < buffer + len; )
+            {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                if (event->len > 0 && filename == event->name)
+                {
+                    conf_changed = true;
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+
+        // Modification time has a one second resolution, but
+        // here we know for sure the file has been written
+        if (conf_changed)
+        {
+            Reload(true);
+        }
+    }
+}
+#endif
+
+void ConfigWatcher::PollingLoop()
+{
+    std::unique_lock<std::mutex> lock(watch_mutex);
+    while (is_running)
+    {
+        watch_condition.wait_for(lock, CONF_POLLING_INTERVAL, [this] { return !is_running; });
+        if (is_running)
+        {
+            Reload(false);
+        }
+    }
+}
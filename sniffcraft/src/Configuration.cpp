@@ -0,0 +1,632 @@
+#include "sniffcraft/Configuration.hpp"
+
+#include <picojson/picojson.h>
+
+#include <protocolCraft/MessageFactory.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// Default maximum number of items waiting to be written by a Logger
+const size_t DEFAULT_LOG_QUEUE_CAPACITY = 100000;
+
+SocketOptions::SocketOptions()
+{
+    nodelay = true;
+    send_buffer = 0;
+    receive_buffer = 0;
+    keepalive = false;
+    keepalive_idle_s = 0;
+    keepalive_interval_s = 0;
+    keepalive_count = 0;
+    user_timeout_ms = 0;
+    quickack = false;
+}
+
+Configuration::Configuration()
+{
+    log_to_console = false;
+    log_mode = LogMode::Packets;
+    packet_stats_interval = std::chrono::seconds(60);
+    packet_stats_top_n = 20;
+    log_format = LogFormat::Text;
+    timestamp_format = TimestampFormat::Relative;
+
+    log_directory = "";
+    log_rotation_size = 0;
+    log_rotation_duration = std::chrono::seconds(0);
+    log_compression = false;
+    log_max_segments = 0;
+
+    latency_stats_enabled = false;
+    latency_dump_interval = std::chrono::seconds(60);
+    latency_stats_file = "latency_stats.txt";
+    latency_top_packets = 10;
+
+    metrics_enabled = false;
+    metrics_port = 9100;
+    decode_threads = 0;
+    log_threads = 2;
+    listen_workers = 1;
+    listen_reuse_port = false;
+    listen_ipv6 = false;
+    listen_backlog = 0;
+    admission_max_connections = 0;
+    admission_max_connections_per_ip = 0;
+    admission_rate = 0.0;
+    admission_burst = 0.0;
+    admission_rate_per_ip = 0.0;
+    admission_burst_per_ip = 0.0;
+    handshake_timeout = std::chrono::seconds(0);
+    login_timeout = std::chrono::seconds(0);
+    idle_timeout = std::chrono::seconds(0);
+
+    log_queue_capacity = DEFAULT_LOG_QUEUE_CAPACITY;
+    log_queue_overflow_policy = LogOverflowPolicy::DropDetailedFirst;
+    log_queue_sample_rate = 10;
+}
+
+const bool Configuration::IsIgnored(const ProtocolCraft::ConnectionState connection_state, const Origin origin, const int id) const
+{
+    auto it = ignored_packets.find({ connection_state, origin });
+    return it != ignored_packets.end() && (it->second.find(id) != it->second.end() || it->second.find(ALL_PACKETS_ID) != it->second.end());
+}
+
+const bool Configuration::IsDetailed(const ProtocolCraft::ConnectionState connection_state, const Origin origin, const int id) const
+{
+    auto it = detailed_packets.find({ connection_state, origin });
+    return it != detailed_packets.end() && (it->second.find(id) != it->second.end() || it->second.find(ALL_PACKETS_ID) != it->second.end());
+}
+
+const bool Configuration::IsAllIgnored(const ProtocolCraft::ConnectionState connection_state, const Origin origin) const
+{
+    auto it = ignored_packets.find({ connection_state, origin });
+    return it != ignored_packets.end() && it->second.find(ALL_PACKETS_ID) != it->second.end();
+}
+
+void LoadPacketList(const picojson::object& object, const std::string& key,
+    const ProtocolCraft::ConnectionState connection_state, const Origin origin, std::set<int>& packets)
+{
+    auto it = object.find(key);
+    if (it == object.end() || !it->second.is<picojson::array>())
+    {
+        return;
+    }
+
+    const picojson::array& list = it->second.get<picojson::array>();
+    for (auto i = list.begin(); i != list.end(); i++)
+    {
+        if (i->is<double>())
+        {
+            packets.insert(static_cast<int>(i->get<double>()));
+        }
+        else if (i->is<std::string>() && i->get<std::string>() == "*")
+        {
+            packets.insert(ALL_PACKETS_ID);
+        }
+        else if (i->is<std::string>())
+        {
+            for (int j = 0; j < 100; ++j)
+            {
+                // Packets sent by the server are clientbound
+                auto msg = origin == Origin::Server ?
+                    ProtocolCraft::MessageFactory::CreateMessageClientbound(j, connection_state) :
+                    ProtocolCraft::MessageFactory::CreateMessageServerbound(j, connection_state);
+                if (msg && msg->GetName() == i->get<std::string>())
+                {
+                    packets.insert(j);
+                }
+            }
+        }
+    }
+}
+
+void LoadPacketsFromJson(const picojson::value& value, const ProtocolCraft::ConnectionState connection_state, Configuration& conf)
+{
+    std::set<int>& ignored_clientbound = conf.ignored_packets[{connection_state, Origin::Server}];
+    std::set<int>& ignored_serverbound = conf.ignored_packets[{connection_state, Origin::Client}];
+    std::set<int>& detailed_clientbound = conf.detailed_packets[{connection_state, Origin::Server}];
+    std::set<int>& detailed_serverbound = conf.detailed_packets[{connection_state, Origin::Client}];
+
+    if (!value.is<picojson::object>())
+    {
+        return;
+    }
+
+    const picojson::object& object = value.get<picojson::object>();
+    LoadPacketList(object, "ignored_clientbound", connection_state, Origin::Server, ignored_clientbound);
+    LoadPacketList(object, "ignored_serverbound", connection_state, Origin::Client, ignored_serverbound);
+    LoadPacketList(object, "detailed_clientbound", connection_state, Origin::Server, detailed_clientbound);
+    LoadPacketList(object, "detailed_serverbound", connection_state, Origin::Client, detailed_serverbound);
+}
+
+void LoadLogFilesFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto directory_value = object.find("directory");
+    if (directory_value != object.end() && directory_value->second.is<std::string>())
+    {
+        conf.log_directory = directory_value->second.get<std::string>();
+    }
+
+    auto max_size_value = object.find("max_size_mb");
+    if (max_size_value != object.end() && max_size_value->second.is<double>() && max_size_value->second.get<double>() > 0)
+    {
+        conf.log_rotation_size = static_cast<unsigned long long>(max_size_value->second.get<double>() * 1024 * 1024);
+    }
+
+    auto max_duration_value = object.find("max_duration_s");
+    if (max_duration_value != object.end() && max_duration_value->second.is<double>() && max_duration_value->second.get<double>() > 0)
+    {
+        conf.log_rotation_duration = std::chrono::seconds(static_cast<long long>(max_duration_value->second.get<double>()));
+    }
+
+    auto compression_value = object.find("compression");
+    if (compression_value != object.end() && compression_value->second.is<std::string>())
+    {
+        const std::string& compression = compression_value->second.get<std::string>();
+        if (compression == "gzip")
+        {
+            conf.log_compression = true;
+        }
+        else if (compression == "none")
+        {
+            conf.log_compression = false;
+        }
+        else
+        {
+            std::cerr << "Unknown LogFiles compression: " << compression << std::endl;
+        }
+    }
+
+    auto max_segments_value = object.find("max_segments");
+    if (max_segments_value != object.end() && max_segments_value->second.is<double>() && max_segments_value->second.get<double>() >= 0)
+    {
+        conf.log_max_segments = static_cast<size_t>(max_segments_value->second.get<double>());
+    }
+}
+
+void LoadLatencyStatsFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto enabled_value = object.find("enabled");
+    if (enabled_value != object.end() && enabled_value->second.is<bool>())
+    {
+        conf.latency_stats_enabled = enabled_value->second.get<bool>();
+    }
+
+    auto interval_value = object.find("dump_interval_s");
+    if (interval_value != object.end() && interval_value->second.is<double>() && interval_value->second.get<double>() >= 1)
+    {
+        conf.latency_dump_interval = std::chrono::seconds(static_cast<long long>(interval_value->second.get<double>()));
+    }
+
+    auto file_value = object.find("stats_file");
+    if (file_value != object.end() && file_value->second.is<std::string>())
+    {
+        conf.latency_stats_file = file_value->second.get<std::string>();
+    }
+
+    auto top_value = object.find("top_packets");
+    if (top_value != object.end() && top_value->second.is<double>() && top_value->second.get<double>() >= 0)
+    {
+        conf.latency_top_packets = static_cast<size_t>(top_value->second.get<double>());
+    }
+}
+
+void LoadMetricsFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto enabled_value = object.find("enabled");
+    if (enabled_value != object.end() && enabled_value->second.is<bool>())
+    {
+        conf.metrics_enabled = enabled_value->second.get<bool>();
+    }
+
+    auto port_value = object.find("port");
+    if (port_value != object.end() && port_value->second.is<double>() &&
+        port_value->second.get<double>() > 0 && port_value->second.get<double>() < 65536)
+    {
+        conf.metrics_port = static_cast<unsigned short>(port_value->second.get<double>());
+    }
+}
+
+void LoadListenFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto workers_value = object.find("workers");
+    if (workers_value != object.end() && workers_value->second.is<double>() && workers_value->second.get<double>() >= 1)
+    {
+        conf.listen_workers = static_cast<unsigned int>(workers_value->second.get<double>());
+    }
+
+    auto reuse_port_value = object.find("reuse_port");
+    if (reuse_port_value != object.end() && reuse_port_value->second.is<bool>())
+    {
+        conf.listen_reuse_port = reuse_port_value->second.get<bool>();
+    }
+
+    auto ipv6_value = object.find("ipv6");
+    if (ipv6_value != object.end() && ipv6_value->second.is<bool>())
+    {
+        conf.listen_ipv6 = ipv6_value->second.get<bool>();
+    }
+
+    auto backlog_value = object.find("backlog");
+    if (backlog_value != object.end() && backlog_value->second.is<double>() && backlog_value->second.get<double>() >= 0)
+    {
+        conf.listen_backlog = static_cast<int>(backlog_value->second.get<double>());
+    }
+}
+
+void LoadAdmissionFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto max_connections_value = object.find("max_connections");
+    if (max_connections_value != object.end() && max_connections_value->second.is<double>() && max_connections_value->second.get<double>() >= 0)
+    {
+        conf.admission_max_connections = static_cast<unsigned int>(max_connections_value->second.get<double>());
+    }
+
+    auto max_connections_per_ip_value = object.find("max_connections_per_ip");
+    if (max_connections_per_ip_value != object.end() && max_connections_per_ip_value->second.is<double>() && max_connections_per_ip_value->second.get<double>() >= 0)
+    {
+        conf.admission_max_connections_per_ip = static_cast<unsigned int>(max_connections_per_ip_value->second.get<double>());
+    }
+
+    auto rate_value = object.find("rate");
+    if (rate_value != object.end() && rate_value->second.is<double>() && rate_value->second.get<double>() >= 0)
+    {
+        conf.admission_rate = rate_value->second.get<double>();
+    }
+
+    auto burst_value = object.find("burst");
+    if (burst_value != object.end() && burst_value->second.is<double>() && burst_value->second.get<double>() >= 0)
+    {
+        conf.admission_burst = burst_value->second.get<double>();
+    }
+
+    auto rate_per_ip_value = object.find("rate_per_ip");
+    if (rate_per_ip_value != object.end() && rate_per_ip_value->second.is<double>() && rate_per_ip_value->second.get<double>() >= 0)
+    {
+        conf.admission_rate_per_ip = rate_per_ip_value->second.get<double>();
+    }
+
+    auto burst_per_ip_value = object.find("burst_per_ip");
+    if (burst_per_ip_value != object.end() && burst_per_ip_value->second.is<double>() && burst_per_ip_value->second.get<double>() >= 0)
+    {
+        conf.admission_burst_per_ip = burst_per_ip_value->second.get<double>();
+    }
+}
+
+void LoadTimeoutsFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto handshake_value = object.find("handshake_s");
+    if (handshake_value != object.end() && handshake_value->second.is<double>() && handshake_value->second.get<double>() >= 0)
+    {
+        conf.handshake_timeout = std::chrono::seconds(static_cast<long long>(handshake_value->second.get<double>()));
+    }
+
+    auto login_value = object.find("login_s");
+    if (login_value != object.end() && login_value->second.is<double>() && login_value->second.get<double>() >= 0)
+    {
+        conf.login_timeout = std::chrono::seconds(static_cast<long long>(login_value->second.get<double>()));
+    }
+
+    auto idle_value = object.find("idle_s");
+    if (idle_value != object.end() && idle_value->second.is<double>() && idle_value->second.get<double>() >= 0)
+    {
+        conf.idle_timeout = std::chrono::seconds(static_cast<long long>(idle_value->second.get<double>()));
+    }
+}
+
+void LoadSocketOptionsFromJson(const picojson::object& object, SocketOptions& options)
+{
+    auto nodelay_value = object.find("nodelay");
+    if (nodelay_value != object.end() && nodelay_value->second.is<bool>())
+    {
+        options.nodelay = nodelay_value->second.get<bool>();
+    }
+
+    auto send_buffer_value = object.find("send_buffer");
+    if (send_buffer_value != object.end() && send_buffer_value->second.is<double>() && send_buffer_value->second.get<double>() >= 0)
+    {
+        options.send_buffer = static_cast<int>(send_buffer_value->second.get<double>());
+    }
+
+    auto receive_buffer_value = object.find("receive_buffer");
+    if (receive_buffer_value != object.end() && receive_buffer_value->second.is<double>() && receive_buffer_value->second.get<double>() >= 0)
+    {
+        options.receive_buffer = static_cast<int>(receive_buffer_value->second.get<double>());
+    }
+
+    auto keepalive_value = object.find("keepalive");
+    if (keepalive_value != object.end() && keepalive_value->second.is<bool>())
+    {
+        options.keepalive = keepalive_value->second.get<bool>();
+    }
+
+    auto keepalive_idle_value = object.find("keepalive_idle_s");
+    if (keepalive_idle_value != object.end() && keepalive_idle_value->second.is<double>() && keepalive_idle_value->second.get<double>() >= 0)
+    {
+        options.keepalive_idle_s = static_cast<int>(keepalive_idle_value->second.get<double>());
+    }
+
+    auto keepalive_interval_value = object.find("keepalive_interval_s");
+    if (keepalive_interval_value != object.end() && keepalive_interval_value->second.is<double>() && keepalive_interval_value->second.get<double>() >= 0)
+    {
+        options.keepalive_interval_s = static_cast<int>(keepalive_interval_value->second.get<double>());
+    }
+
+    auto keepalive_count_value = object.find("keepalive_count");
+    if (keepalive_count_value != object.end() && keepalive_count_value->second.is<double>() && keepalive_count_value->second.get<double>() >= 0)
+    {
+        options.keepalive_count = static_cast<int>(keepalive_count_value->second.get<double>());
+    }
+
+    auto user_timeout_value = object.find("user_timeout_ms");
+    if (user_timeout_value != object.end() && user_timeout_value->second.is<double>() && user_timeout_value->second.get<double>() >= 0)
+    {
+        options.user_timeout_ms = static_cast<unsigned int>(user_timeout_value->second.get<double>());
+    }
+
+    auto quickack_value = object.find("quickack");
+    if (quickack_value != object.end() && quickack_value->second.is<bool>())
+    {
+        options.quickack = quickack_value->second.get<bool>();
+    }
+}
+
+void LoadPacketStatsFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto interval_value = object.find("interval_s");
+    if (interval_value != object.end() && interval_value->second.is<double>() && interval_value->second.get<double>() >= 1)
+    {
+        conf.packet_stats_interval = std::chrono::seconds(static_cast<long long>(interval_value->second.get<double>()));
+    }
+
+    auto top_n_value = object.find("top_n");
+    if (top_n_value != object.end() && top_n_value->second.is<double>() && top_n_value->second.get<double>() >= 0)
+    {
+        conf.packet_stats_top_n = static_cast<size_t>(top_n_value->second.get<double>());
+    }
+}
+
+void LoadLogQueueFromJson(const picojson::object& object, Configuration& conf)
+{
+    auto capacity_value = object.find("capacity");
+    if (capacity_value != object.end() && capacity_value->second.is<double>() && capacity_value->second.get<double>() >= 1)
+    {
+        conf.log_queue_capacity = static_cast<size_t>(capacity_value->second.get<double>());
+    }
+
+    auto sample_rate_value = object.find("sample_rate");
+    if (sample_rate_value != object.end() && sample_rate_value->second.is<double>() && sample_rate_value->second.get<double>() >= 1)
+    {
+        conf.log_queue_sample_rate = static_cast<unsigned int>(sample_rate_value->second.get<double>());
+    }
+
+    auto policy_value = object.find("overflow_policy");
+    if (policy_value != object.end() && policy_value->second.is<std::string>())
+    {
+        const std::string& policy = policy_value->second.get<std::string>();
+        if (policy == "block")
+        {
+            conf.log_queue_overflow_policy = LogOverflowPolicy::Block;
+        }
+        else if (policy == "drop_newest")
+        {
+            conf.log_queue_overflow_policy = LogOverflowPolicy::DropNewest;
+        }
+        else if (policy == "drop_detailed_first")
+        {
+            conf.log_queue_overflow_policy = LogOverflowPolicy::DropDetailedFirst;
+        }
+        else if (policy == "sample")
+        {
+            conf.log_queue_overflow_policy = LogOverflowPolicy::Sample;
+        }
+        else
+        {
+            std::cerr << "Unknown LogQueue overflow_policy: " << policy << std::endl;
+        }
+    }
+}
+
+std::shared_ptr<const Configuration> LoadConfiguration(const std::string& path)
+{
+    if (path == "")
+    {
+        return nullptr;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Error trying to open conf file: " << path << "." << std::endl;
+        return nullptr;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    file.close();
+
+    picojson::value json;
+    ss >> json;
+    std::string err = picojson::get_last_error();
+
+    if (!err.empty())
+    {
+        std::cerr << "Error parsing conf file at " << path << ".\n";
+        std::cerr << err << "\n" << std::endl;
+        return nullptr;
+    }
+    if (!json.is<picojson::object>())
+    {
+        std::cerr << "Error parsing conf file at " << path << "." << std::endl;
+        return nullptr;
+    }
+
+    const std::map<std::string, ProtocolCraft::ConnectionState> name_mapping = {
+        {"Handshaking", ProtocolCraft::ConnectionState::Handshake},
+        {"Status", ProtocolCraft::ConnectionState::Status},
+        {"Login", ProtocolCraft::ConnectionState::Login},
+        {"Play", ProtocolCraft::ConnectionState::Play}
+    };
+
+    const picojson::value::object& obj = json.get<picojson::object>();
+
+    std::shared_ptr<Configuration> conf = std::make_shared<Configuration>();
+
+    auto log_to_console_value = obj.find("LogToConsole");
+    if (log_to_console_value != obj.end() && log_to_console_value->second.is<bool>())
+    {
+        conf->log_to_console = log_to_console_value->second.get<bool>();
+    }
+
+    auto log_mode_value = obj.find("LogMode");
+    if (log_mode_value != obj.end() && log_mode_value->second.is<std::string>())
+    {
+        const std::string& mode = log_mode_value->second.get<std::string>();
+        if (mode == "packets")
+        {
+            conf->log_mode = LogMode::Packets;
+        }
+        else if (mode == "stats")
+        {
+            conf->log_mode = LogMode::Stats;
+        }
+        else
+        {
+            std::cerr << "Unknown LogMode: " << mode << std::endl;
+        }
+    }
+
+    auto packet_stats_value = obj.find("PacketStats");
+    if (packet_stats_value != obj.end() && packet_stats_value->second.is<picojson::object>())
+    {
+        LoadPacketStatsFromJson(packet_stats_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto log_format_value = obj.find("LogFormat");
+    if (log_format_value != obj.end() && log_format_value->second.is<std::string>())
+    {
+        const std::string& format = log_format_value->second.get<std::string>();
+        if (format == "text")
+        {
+            conf->log_format = LogFormat::Text;
+        }
+        else if (format == "jsonl")
+        {
+            conf->log_format = LogFormat::JsonLines;
+        }
+        else
+        {
+            std::cerr << "Unknown LogFormat: " << format << std::endl;
+        }
+    }
+
+    auto timestamp_format_value = obj.find("TimestampFormat");
+    if (timestamp_format_value != obj.end() && timestamp_format_value->second.is<std::string>())
+    {
+        const std::string& format = timestamp_format_value->second.get<std::string>();
+        if (format == "relative")
+        {
+            conf->timestamp_format = TimestampFormat::Relative;
+        }
+        else if (format == "absolute")
+        {
+            conf->timestamp_format = TimestampFormat::Absolute;
+        }
+        else if (format == "monotonic")
+        {
+            conf->timestamp_format = TimestampFormat::Monotonic;
+        }
+        else
+        {
+            std::cerr << "Unknown TimestampFormat: " << format << std::endl;
+        }
+    }
+
+    auto log_files_value = obj.find("LogFiles");
+    if (log_files_value != obj.end() && log_files_value->second.is<picojson::object>())
+    {
+        LoadLogFilesFromJson(log_files_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto latency_stats_value = obj.find("LatencyStats");
+    if (latency_stats_value != obj.end() && latency_stats_value->second.is<picojson::object>())
+    {
+        LoadLatencyStatsFromJson(latency_stats_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto metrics_value = obj.find("Metrics");
+    if (metrics_value != obj.end() && metrics_value->second.is<picojson::object>())
+    {
+        LoadMetricsFromJson(metrics_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto decode_threads_value = obj.find("DecodeThreads");
+    if (decode_threads_value != obj.end() && decode_threads_value->second.is<double>() && decode_threads_value->second.get<double>() >= 0)
+    {
+        conf->decode_threads = static_cast<unsigned int>(decode_threads_value->second.get<double>());
+    }
+
+    auto log_threads_value = obj.find("LogThreads");
+    if (log_threads_value != obj.end() && log_threads_value->second.is<double>() && log_threads_value->second.get<double>() >= 1)
+    {
+        conf->log_threads = static_cast<unsigned int>(log_threads_value->second.get<double>());
+    }
+
+    auto listen_value = obj.find("Listen");
+    if (listen_value != obj.end() && listen_value->second.is<picojson::object>())
+    {
+        LoadListenFromJson(listen_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto admission_value = obj.find("Admission");
+    if (admission_value != obj.end() && admission_value->second.is<picojson::object>())
+    {
+        LoadAdmissionFromJson(admission_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto timeouts_value = obj.find("Timeouts");
+    if (timeouts_value != obj.end() && timeouts_value->second.is<picojson::object>())
+    {
+        LoadTimeoutsFromJson(timeouts_value->second.get<picojson::object>(), *conf);
+    }
+
+    auto sockets_value = obj.find("Sockets");
+    if (sockets_value != obj.end() && sockets_value->second.is<picojson::object>())
+    {
+        const picojson::object& sockets = sockets_value->second.get<picojson::object>();
+        auto client_value = sockets.find("client");
+        if (client_value != sockets.end() && client_value->second.is<picojson::object>())
+        {
+            LoadSocketOptionsFromJson(client_value->second.get<picojson::object>(), conf->client_socket_options);
+        }
+        auto server_value = sockets.find("server");
+        if (server_value != sockets.end() && server_value->second.is<picojson::object>())
+        {
+            LoadSocketOptionsFromJson(server_value->second.get<picojson::object>(), conf->server_socket_options);
+        }
+    }
+
+    auto log_queue_value = obj.find("LogQueue");
+    if (log_queue_value != obj.end() && log_queue_value->second.is<picojson::object>())
+    {
+        LoadLogQueueFromJson(log_queue_value->second.get<picojson::object>(), *conf);
+    }
+
+    for (auto it = name_mapping.begin(); it != name_mapping.end(); ++it)
+    {
+        auto it2 = obj.find(it->first);
+        if (it2 != obj.end())
+        {
+            LoadPacketsFromJson(it2->second, it->second, *conf);
+        }
+        else
+        {
+            const picojson::value null_value = picojson::value();
+            LoadPacketsFromJson(null_value, it->second, *conf);
+        }
+    }
+
+    return conf;
+}
@@ -0,0 +1,60 @@
+#include "sniffcraft/DNSCache.hpp"
+#include "sniffcraft/Metrics.hpp"
+
+#include <memory>
+
+// We don't get the TTL of the records from the resolver
+const std::chrono::seconds DNS_CACHE_DURATION(60);
+
+DNSCache& DNSCache::GetInstance()
+{
+    static DNSCache instance;
+    return instance;
+}
+
+DNSCache::DNSCache()
+{
+
+}
+
+void DNSCache::AsyncResolve(asio::io_context& io_context, const std::string& host, const unsigned short port, const ResolveHandler& handler)
+{
+    const std::pair<std::string, unsigned short> key(host, port);
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && it->second.expiration > std::chrono::steady_clock::now())
+        {
+            Metrics::Add(MetricCounter::DNSCacheHits);
+            const std::vector<asio::ip::tcp::endpoint> endpoints = it->second.endpoints;
+            asio::post(io_context, [handler, endpoints]()
+                {
+                    handler(asio::error_code(), endpoints);
+                });
+            return;
+        }
+    }
+
+    Metrics::Add(MetricCounter::DNSCacheMisses);
+
+    // Kept alive by the handler until the resolution completes
+    std::shared_ptr<asio::ip::tcp::resolver> resolver = std::make_shared<asio::ip::tcp::resolver>(io_context);
+    asio::ip::tcp::resolver::query query(host, std::to_string(port));
+    resolver->async_resolve(query, [this, resolver, key, handler](const asio::error_code& ec, asio::ip::tcp::resolver::iterator iterator)
+        {
+            Entry entry;
+            if (!ec)
+            {
+                for (; iterator != asio::ip::tcp::resolver::iterator(); ++iterator)
+                {
+                    entry.endpoints.push_back(iterator->endpoint());
+                }
+                entry.expiration = std::chrono::steady_clock::now() + DNS_CACHE_DURATION;
+
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                cache[key] = entry;
+            }
+            handler(ec, entry.endpoints);
+        });
+}
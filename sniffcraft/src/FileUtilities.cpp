@@ -3,10 +3,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <cerrno>
+
 #ifndef WIN32
 #include <unistd.h>
 #else
+#include <direct.h>
 #define stat _stat
+#define mkdir(path, mode) _mkdir(path)
 #endif
 
 const std::time_t GetModifiedTimestamp(const std::string& path)
@@ -17,4 +21,28 @@ const std::time_t GetModifiedTimestamp(const std::string& path)
         return result.st_mtime;
     }
     return -1;
-}
\ No newline at end of file
+}
+
+const bool CreateDirectories(const std::string& path)
+{
+    if (path.empty())
+    {
+        return true;
+    }
+
+    // Create each parent in order
+    for (size_t i = 1; i <= path.size(); ++i)
+    {
+        if (i != path.size() && path[i] != '/' && path[i] != '\\')
+        {
+            continue;
+        }
+
+        const std::string current = path.substr(0, i);
+        if (mkdir(current.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "sniffcraft/FrameScanner.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SNIFFCRAFT_FRAME_SCANNER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef SNIFFCRAFT_FRAME_SCANNER_SSE2
+inline int CountTrailingZeros(const unsigned int x)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(x);
+#endif
+}
+#endif
+
+inline int DecodeVarIntScalar(const unsigned char* data, const size_t available, int& value)
+{
+    unsigned int result = 0;
+    const size_t max_bytes = available < MAX_VARINT_LENGTH ? available : MAX_VARINT_LENGTH;
+    for (size_t i = 0; i < max_bytes; ++i)
+    {
+        result |= static_cast<unsigned int>(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0)
+        {
+            value = static_cast<int>(result);
+            return static_cast<int>(i + 1);
+        }
+    }
+    return available < MAX_VARINT_LENGTH ? 0 : -1;
+}
+
+const int DecodeVarInt(const unsigned char* data, const size_t available, int& value)
+{
+#ifdef SNIFFCRAFT_FRAME_SCANNER_SSE2
+    if (available >= 16)
+    {
+        // One bit per byte, set if the continuation bit is set,
+        // the first unset bit gives the VarInt length
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const unsigned int continuation = static_cast<unsigned int>(_mm_movemask_epi8(bytes));
+        const int length = CountTrailingZeros(~continuation) + 1;
+        if (length > MAX_VARINT_LENGTH)
+        {
+            return -1;
+        }
+
+        // No loop dependency on the continuation bits
+        unsigned int result = data[0] & 0x7F;
+        result |= length > 1 ? static_cast<unsigned int>(data[1] & 0x7F) << 7 : 0;
+        result |= length > 2 ? static_cast<unsigned int>(data[2] & 0x7F) << 14 : 0;
+        result |= length > 3 ? static_cast<unsigned int>(data[3] & 0x7F) << 21 : 0;
+        result |= length > 4 ? static_cast<unsigned int>(data[4] & 0x7F) << 28 : 0;
+        value = static_cast<int>(result);
+        return length;
+    }
+#endif
+    return DecodeVarIntScalar(data, available, value);
+}
+
+const size_t VarIntSize(const int value)
+{
+    unsigned int remaining = static_cast<unsigned int>(value);
+    size_t size = 1;
+    while (remaining >= 0x80)
+    {
+        remaining >>= 7;
+        size += 1;
+    }
+    return size;
+}
+
+void EncodeVarInt(const int value, unsigned char* output)
+{
+    unsigned int remaining = static_cast<unsigned int>(value);
+    while (remaining >= 0x80)
+    {
+        *output = static_cast<unsigned char>(remaining & 0x7F) | 0x80;
+        remaining >>= 7;
+        output += 1;
+    }
+    *output = static_cast<unsigned char>(remaining);
+}
+
+const size_t ScanFrames(const unsigned char* data, const size_t size, std::vector<FrameSpan>& spans)
+{
+    spans.clear();
+
+    size_t offset = 0;
+    while (offset < size)
+    {
+        int length = 0;
+        const int header_length = DecodeVarInt(data + offset, size - offset, length);
+        // Incomplete or invalid header
+        if (header_length <= 0 || length <= 0)
+        {
+            break;
+        }
+
+        // Incomplete packet
+        if (size - offset - header_length < static_cast<size_t>(length))
+        {
+            break;
+        }
+
+        FrameSpan span;
+        span.offset = offset;
+        span.header_length = header_length;
+        span.length = length;
+        spans.push_back(span);
+
+        offset += header_length + length;
+    }
+
+    return offset;
+}
@@ -0,0 +1,35 @@
+#include "sniffcraft/HostRouter.hpp"
+
+void HostRouter::Add(const std::string& hostname, const Upstream& upstream)
+{
+    upstreams[NormalizeHostname(hostname)] = upstream;
+}
+
+const Upstream* HostRouter::Find(const std::string& handshake_address) const
+{
+    auto it = upstreams.find(NormalizeHostname(handshake_address));
+    return it == upstreams.end() ? nullptr : &it->second;
+}
+
+const std::string HostRouter::NormalizeHostname(const std::string& address)
+{
+    size_t length = address.find('\0');
+    if (length == std::string::npos)
+    {
+        length = address.size();
+    }
+    while (length > 0 && address[length - 1] == '.')
+    {
+        length -= 1;
+    }
+
+    std::string hostname(address, 0, length);
+    for (size_t i = 0; i < hostname.size(); ++i)
+    {
+        if (hostname[i] >= 'A' && hostname[i] <= 'Z')
+        {
+            hostname[i] = hostname[i] - 'A' + 'a';
+        }
+    }
+    return hostname;
+}
@@ -0,0 +1,209 @@
+#include "sniffcraft/JsonWriter.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+JsonWriter::JsonWriter(std::string& output_) : output(output_)
+{
+    after_key = false;
+}
+
+void JsonWriter::StartObject()
+{
+    BeforeValue();
+    output += '{';
+    has_element.push_back(false);
+}
+
+void JsonWriter::EndObject()
+{
+    output += '}';
+    has_element.pop_back();
+}
+
+void JsonWriter::StartArray()
+{
+    BeforeValue();
+    output += '[';
+    has_element.push_back(false);
+}
+
+void JsonWriter::EndArray()
+{
+    output += ']';
+    has_element.pop_back();
+}
+
+void JsonWriter::Key(const std::string& key)
+{
+    BeforeValue();
+    output += '"';
+    WriteEscaped(key.data(), key.size());
+    output += "\":";
+    after_key = true;
+}
+
+void JsonWriter::String(const std::string& value)
+{
+    String(value.data(), value.size());
+}
+
+void JsonWriter::String(const char* value, const size_t length)
+{
+    BeforeValue();
+    output += '"';
+    WriteEscaped(value, length);
+    output += '"';
+}
+
+void JsonWriter::Integer(const long long value)
+{
+    BeforeValue();
+    char buffer[24];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%lld", value);
+    output.append(buffer, length);
+}
+
+void JsonWriter::Number(const double value)
+{
+    // JSON has no representation for these
+    if (std::isnan(value) || std::isinf(value))
+    {
+        Null();
+        return;
+    }
+
+    // Same output as picojson for integral values
+    if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0)
+    {
+        Integer(static_cast<long long>(value));
+        return;
+    }
+
+    BeforeValue();
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    output.append(buffer, length);
+}
+
+void JsonWriter::Bool(const bool value)
+{
+    BeforeValue();
+    output += value ? "true" : "false";
+}
+
+void JsonWriter::Null()
+{
+    BeforeValue();
+    output += "null";
+}
+
+void JsonWriter::Value(const picojson::value& value)
+{
+    if (value.is<picojson::null>())
+    {
+        Null();
+    }
+    else if (value.is<bool>())
+    {
+        Bool(value.get<bool>());
+    }
+#ifdef PICOJSON_USE_INT64
+    else if (value.is<int64_t>())
+    {
+        Integer(value.get<int64_t>());
+    }
+#endif
+    else if (value.is<double>())
+    {
+        Number(value.get<double>());
+    }
+    else if (value.is<std::string>())
+    {
+        String(value.get<std::string>());
+    }
+    else if (value.is<picojson::array>())
+    {
+        StartArray();
+        const picojson::array& array = value.get<picojson::array>();
+        for (auto it = array.begin(); it != array.end(); ++it)
+        {
+            Value(*it);
+        }
+        EndArray();
+    }
+    else if (value.is<picojson::object>())
+    {
+        StartObject();
+        const picojson::object& object = value.get<picojson::object>();
+        for (auto it = object.begin(); it != object.end(); ++it)
+        {
+            Key(it->first);
+            Value(it->second);
+        }
+        EndObject();
+    }
+}
+
+void JsonWriter::BeforeValue()
+{
+    if (after_key)
+    {
+        after_key = false;
+        return;
+    }
+
+    if (!has_element.empty())
+    {
+        if (has_element.back())
+        {
+            output += ',';
+        }
+        has_element.back() = true;
+    }
+}
+
+void JsonWriter::WriteEscaped(const char* value, const size_t length)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    size_t unescaped_start = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        // Copy everything that didn't need escaping in one go
+        output.append(value + unescaped_start, i - unescaped_start);
+        unescaped_start = i + 1;
+
+        switch (c)
+        {
+        case '"':
+            output += "\\\"";
+            break;
+        case '\\':
+            output += "\\\\";
+            break;
+        case '\n':
+            output += "\\n";
+            break;
+        case '\r':
+            output += "\\r";
+            break;
+        case '\t':
+            output += "\\t";
+            break;
+        default:
+            output += "\\u00";
+            output += hex_digits[c >> 4];
+            output += hex_digits[c & 0x0F];
+            break;
+        }
+    }
+    output.append(value + unescaped_start, length - unescaped_start);
+}
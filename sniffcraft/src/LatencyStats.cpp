@@ -0,0 +1,250 @@
+#include "sniffcraft/LatencyStats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include <protocolCraft/MessageFactory.hpp>
+
+const int LatencyHistogram::SUB_BUCKET_BITS;
+const int LatencyHistogram::SUB_BUCKET_COUNT;
+const int LatencyHistogram::MAX_EXPONENT;
+const int LatencyHistogram::BUCKET_COUNT;
+
+LatencyHistogram::LatencyHistogram() : counts(BUCKET_COUNT, 0)
+{
+    total_count = 0;
+    max_value = 0;
+}
+
+void LatencyHistogram::Record(const long long value)
+{
+    const long long positive_value = value < 0 ? 0 : value;
+    counts[BucketIndex(positive_value)] += 1;
+    total_count += 1;
+    max_value = std::max(max_value, positive_value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        counts[i] += other.counts[i];
+    }
+    total_count += other.total_count;
+    max_value = std::max(max_value, other.max_value);
+}
+
+void LatencyHistogram::Reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total_count = 0;
+    max_value = 0;
+}
+
+const unsigned long long LatencyHistogram::GetCount() const
+{
+    return total_count;
+}
+
+const long long LatencyHistogram::GetMax() const
+{
+    return max_value;
+}
+
+const long long LatencyHistogram::GetPercentile(const double percentile) const
+{
+    if (total_count == 0)
+    {
+        return 0;
+    }
+
+    const unsigned long long rank = std::max(1ULL, static_cast<unsigned long long>(percentile / 100.0 * total_count + 0.5));
+    unsigned long long cumulated = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        cumulated += counts[i];
+        if (cumulated >= rank)
+        {
+            return std::min(BucketUpperBound(i), max_value);
+        }
+    }
+    return max_value;
+}
+
+const int LatencyHistogram::BucketIndex(const long long value)
+{
+    // Values below SUB_BUCKET_COUNT each have their own bucket
+    if (value < SUB_BUCKET_COUNT)
+    {
+        return static_cast<int>(value);
+    }
+
+    int exponent = 0;
+    for (unsigned long long v = static_cast<unsigned long long>(value); v > 1; v >>= 1)
+    {
+        exponent += 1;
+    }
+    // The last bucket covers values up to 2^MAX_EXPONENT - 1
+    if (exponent >= MAX_EXPONENT)
+    {
+        return BUCKET_COUNT - 1;
+    }
+
+    // The SUB_BUCKET_BITS bits following the leading one
+    const int sub_bucket = static_cast<int>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + sub_bucket;
+}
+
+const long long LatencyHistogram::BucketUpperBound(const int index)
+{
+    if (index < SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+
+    const int exponent = index / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+    const int sub_bucket = index % SUB_BUCKET_COUNT;
+    const long long lower_bound = (1LL << exponent) + (static_cast<long long>(sub_bucket) << (exponent - SUB_BUCKET_BITS));
+    return lower_bound + (1LL << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+
+void LatencyStats::Record(const Origin origin, const PacketTiming& timing, const std::chrono::steady_clock::time_point& written)
+{
+    std::array<LatencyHistogram, static_cast<int>(LatencyStage::NUM_LATENCY_STAGE)>& histograms = stage_histograms[static_cast<int>(origin)];
+
+    const long long total = std::chrono::duration_cast<std::chrono::nanoseconds>(written - timing.read).count();
+    histograms[static_cast<int>(LatencyStage::Framing)].Record(std::chrono::duration_cast<std::chrono::nanoseconds>(timing.framed - timing.read).count());
+    if (timing.decoded)
+    {
+        histograms[static_cast<int>(LatencyStage::Parsing)].Record(std::chrono::duration_cast<std::chrono::nanoseconds>(timing.parsed - timing.framed).count());
+    }
+    histograms[static_cast<int>(LatencyStage::Forwarding)].Record(std::chrono::duration_cast<std::chrono::nanoseconds>(written - timing.parsed).count());
+    histograms[static_cast<int>(LatencyStage::Total)].Record(total);
+
+    packet_histograms[std::make_tuple(static_cast<int>(origin), static_cast<int>(timing.connection_state), timing.id)].Record(total);
+}
+
+void LatencyStats::Merge(const LatencyStats& other)
+{
+    for (size_t i = 0; i < stage_histograms.size(); ++i)
+    {
+        for (size_t j = 0; j < stage_histograms[i].size(); ++j)
+        {
+            stage_histograms[i][j].Merge(other.stage_histograms[i][j]);
+        }
+    }
+
+    for (auto it = other.packet_histograms.begin(); it != other.packet_histograms.end(); ++it)
+    {
+        packet_histograms[it->first].Merge(it->second);
+    }
+}
+
+void LatencyStats::Reset()
+{
+    for (size_t i = 0; i < stage_histograms.size(); ++i)
+    {
+        for (size_t j = 0; j < stage_histograms[i].size(); ++j)
+        {
+            stage_histograms[i][j].Reset();
+        }
+    }
+    packet_histograms.clear();
+}
+
+const bool LatencyStats::IsEmpty() const
+{
+    return packet_histograms.empty();
+}
+
+void WriteHistogramLine(std::stringstream& output, const std::string& name, const LatencyHistogram& histogram)
+{
+    // Everything is displayed in microseconds
+    output << "    " << std::left << std::setw(40) << name << std::right
+        << std::setw(10) << histogram.GetCount()
+        << std::setw(10) << histogram.GetPercentile(50.0) / 1000
+        << std::setw(10) << histogram.GetPercentile(90.0) / 1000
+        << std::setw(10) << histogram.GetPercentile(99.0) / 1000
+        << std::setw(10) << histogram.GetPercentile(99.9) / 1000
+        << std::setw(10) << histogram.GetMax() / 1000 << "\n";
+}
+
+const std::string LatencyStats::ToString(const size_t top_n) const
+{
+    const char* stage_names[] = { "framing", "parsing", "forwarding", "total" };
+
+    std::stringstream output;
+    for (int origin = 0; origin < 2; ++origin)
+    {
+        const bool is_server = static_cast<Origin>(origin) == Origin::Server;
+        output << (is_server ? "[S --> C]" : "[C --> S]") << " latency (us)"
+            << std::setw(32) << "count" << std::setw(10) << "p50" << std::setw(10) << "p90"
+            << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+
+        for (int stage = 0; stage < static_cast<int>(LatencyStage::NUM_LATENCY_STAGE); ++stage)
+        {
+            WriteHistogramLine(output, stage_names[stage], stage_histograms[origin][stage]);
+        }
+
+        // Slowest packets first
+        std::vector<std::pair<long long, std::map<std::tuple<int, int, int>, LatencyHistogram>::const_iterator> > packets;
+        for (auto it = packet_histograms.begin(); it != packet_histograms.end(); ++it)
+        {
+            if (std::get<0>(it->first) == origin)
+            {
+                packets.push_back({ it->second.GetPercentile(99.0), it });
+            }
+        }
+        std::sort(packets.begin(), packets.end(),
+            [](const std::pair<long long, std::map<std::tuple<int, int, int>, LatencyHistogram>::const_iterator>& a,
+                const std::pair<long long, std::map<std::tuple<int, int, int>, LatencyHistogram>::const_iterator>& b)
+            {
+                return a.first > b.first;
+            });
+
+        for (size_t i = 0; i < packets.size() && i < top_n; ++i)
+        {
+            const ProtocolCraft::ConnectionState connection_state = static_cast<ProtocolCraft::ConnectionState>(std::get<1>(packets[i].second->first));
+            const int id = std::get<2>(packets[i].second->first);
+            if (id < 0)
+            {
+                // Compressed packets forwarded before decoding, or unreadable ones
+                WriteHistogramLine(output, "Unidentified (id not read)", packets[i].second->second);
+                continue;
+            }
+            auto msg = is_server ?
+                ProtocolCraft::MessageFactory::CreateMessageClientbound(id, connection_state) :
+                ProtocolCraft::MessageFactory::CreateMessageServerbound(id, connection_state);
+            WriteHistogramLine(output, msg == nullptr ? "Unknown (" + std::to_string(id) + ")" : msg->GetName(), packets[i].second->second);
+        }
+    }
+
+    return output.str();
+}
+
+std::mutex& GlobalLatencyMutex()
+{
+    static std::mutex global_mutex;
+    return global_mutex;
+}
+
+LatencyStats& GlobalLatencyStats()
+{
+    static LatencyStats global_stats;
+    return global_stats;
+}
+
+void LatencyStats::MergeIntoGlobal(const LatencyStats& stats)
+{
+    std::lock_guard<std::mutex> lock(GlobalLatencyMutex());
+    GlobalLatencyStats().Merge(stats);
+}
+
+const std::string LatencyStats::GlobalToString(const size_t top_n)
+{
+    std::lock_guard<std::mutex> lock(GlobalLatencyMutex());
+    return GlobalLatencyStats().ToString(top_n);
+}
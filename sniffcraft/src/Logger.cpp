@@ -3,336 +3,494 @@
 #include <sstream>
 #include <iomanip>
 
-#include <protocolCraft/MessageFactory.hpp>
-#include <protocolCraft/Handler.hpp>
-#include <sniffcraft/FileUtilities.hpp>
+#include "sniffcraft/ConfigWatcher.hpp"
+#include "sniffcraft/JsonWriter.hpp"
+#include "sniffcraft/LoggerService.hpp"
+#include "sniffcraft/Metrics.hpp"
+#include "sniffcraft/Profiler.hpp"
 
-Logger::Logger(const std::string &conf_path)
+// The writer gives back capacity to the producers every this number of written items
+const size_t IN_FLIGHT_RELEASE_STEP = 256;
+
+// Messages waiting for the decoder to take them, the others are freed
+const size_t MAX_RELEASED_MESSAGES = 1024;
+
+const char* ConnectionStateName(const ProtocolCraft::ConnectionState connection_state)
 {
-    logfile_path = conf_path;
-    LoadConfig(logfile_path);
+    switch (connection_state)
+    {
+    case ProtocolCraft::ConnectionState::Handshake:
+        return "Handshaking";
+    case ProtocolCraft::ConnectionState::Status:
+        return "Status";
+    case ProtocolCraft::ConnectionState::Login:
+        return "Login";
+    case ProtocolCraft::ConnectionState::Play:
+        return "Play";
+    default:
+        return "None";
+    }
+}
+
+Logger::Logger(LoggerService& service_, const ConfigWatcher& config_watcher_, const unsigned long long session_id_) :
+    service(service_),
+    config_watcher(config_watcher_),
+    session_id(session_id_)
+{
+    configuration_version = config_watcher.GetVersion();
+    configuration = config_watcher.GetConfiguration();
+
+    sample_counter = 0;
+    in_flight_items = 0;
+    scheduled = false;
+    has_released_messages = false;
+    dropped_items = 0;
+    dropped_details = 0;
+    sampled_out_items = 0;
+    session_started = false;
+    log_format = configuration->log_format;
+
+    if (configuration->log_mode == LogMode::Stats)
+    {
+        packet_stats = std::unique_ptr<PacketStats>(new PacketStats());
+        last_packet_stats_dump = std::chrono::steady_clock::now();
+        packet_stats_interval = configuration->packet_stats_interval;
+        packet_stats_top_n = configuration->packet_stats_top_n;
+        packets_since_stats_check = 0;
+    }
 
     is_running = true;
-    log_thread = std::thread(&Logger::LogConsume, this);
+}
+
+std::shared_ptr<Logger> Logger::Create(LoggerService& service_, const ConfigWatcher& config_watcher_, const unsigned long long session_id_)
+{
+    return std::shared_ptr<Logger>(new Logger(service_, config_watcher_, session_id_));
 }
 
 Logger::~Logger()
 {
-    is_running = false;
-    log_condition.notify_all();
+    log_file.Close();
+}
 
-    while (!logging_queue.empty())
+void Logger::Stop()
+{
+    if (packet_stats != nullptr && !packet_stats->IsEmpty())
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        LogMessage("Session " + packet_stats->ToString(packet_stats_top_n));
     }
 
-    log_file.close();
-
-    if (log_thread.joinable())
     {
-        log_thread.join();
+        std::lock_guard<std::mutex> log_guard(log_mutex);
+        is_running = false;
     }
+    queue_not_full_condition.notify_all();
 }
 
-void Logger::Log(const std::shared_ptr<ProtocolCraft::Message> msg, const ProtocolCraft::ConnectionState connection_state, const Origin origin)
+void Logger::Log(std::shared_ptr<ProtocolCraft::Message> msg, const ProtocolCraft::ConnectionState connection_state, const Origin origin)
 {
-    std::lock_guard<std::mutex> log_guard(log_mutex);
-    if (!log_file.is_open())
+    bool schedule = false;
     {
-        start_time = std::chrono::system_clock::now();
-        auto in_time_t = std::chrono::system_clock::to_time_t(start_time);
+        std::unique_lock<std::mutex> lock(log_mutex);
+        if (!is_running)
+        {
+            return;
+        }
 
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d-%H-%M-%S")
-            << "_log.txt";
+        UpdateConfiguration();
 
-        log_file = std::ofstream(ss.str(), std::ios::out);
+        LogItem item{ std::move(msg), std::chrono::system_clock::now(), std::chrono::steady_clock::now(), connection_state, origin, false, std::string() };
+
+        if (item.msg != nullptr)
+        {
+            // Ignored packets never take a slot in the queue
+            if (configuration->IsIgnored(connection_state, origin, item.msg->GetId()))
+            {
+                return;
+            }
+            item.is_detailed = configuration->IsDetailed(connection_state, origin, item.msg->GetId());
+        }
+
+        schedule = Enqueue(lock, item);
+    }
+    if (schedule)
+    {
+        service.Schedule(shared_from_this());
     }
+}
+
+const bool Logger::HasReleasedMessages() const
+{
+    return has_released_messages.load(std::memory_order_acquire);
+}
 
-    logging_queue.push_back({ msg, std::chrono::system_clock::now(), connection_state, origin });
-    log_condition.notify_all();
+void Logger::TakeReleasedMessages(std::vector<ReleasedMessage>& messages)
+{
+    std::lock_guard<std::mutex> lock(released_mutex);
+    messages.swap(released_messages);
+    released_messages.clear();
+    has_released_messages.store(false, std::memory_order_release);
+}
+
+void Logger::UpdateConfiguration()
+{
+    const unsigned int latest_version = config_watcher.GetVersion();
+    if (latest_version != configuration_version)
+    {
+        configuration_version = latest_version;
+        configuration = config_watcher.GetConfiguration();
+        sample_counter = 0;
+        queue_not_full_condition.notify_all();
+    }
 }
 
-void Logger::LogConsume()
+void Logger::LogMessage(const std::string& message)
 {
-    while (is_running)
+    bool schedule = false;
     {
+        std::unique_lock<std::mutex> lock(log_mutex);
+        if (!is_running)
         {
-            std::unique_lock<std::mutex> lock(log_mutex);
-            log_condition.wait(lock);
+            return;
         }
-        while (!logging_queue.empty())
-        {
-            LogItem item;
-            {
-                std::lock_guard<std::mutex> log_guard(log_mutex);
-                item = logging_queue.front();
-                logging_queue.pop_front();
-            }
 
-            auto milisec = std::chrono::duration_cast<std::chrono::milliseconds>(item.date - start_time).count();
-            auto sec = std::chrono::duration_cast<std::chrono::seconds>(item.date - start_time).count();
-            auto min = std::chrono::duration_cast<std::chrono::minutes>(item.date - start_time).count();
-            auto hours = std::chrono::duration_cast<std::chrono::hours>(item.date - start_time).count();
+        UpdateConfiguration();
 
-            std::stringstream output;
+        LogItem item{ nullptr, std::chrono::system_clock::now(), std::chrono::steady_clock::now(), ProtocolCraft::ConnectionState::Handshake, Origin::Server, false, message };
 
-            if (item.msg == nullptr)
-            {
-                output << "[" << hours << ":" << min << ":" << sec << ":" << milisec << "] "
-                    << (item.origin == Origin::Server ? "[S --> C] " : "[C --> S] ");
-                output << "UNKNOWN OR WRONGLY PARSED MESSAGE";
-                const std::string output_str = output.str();
-                log_file << output_str << std::endl;
-                if (log_to_console)
-                {
-                    std::cout << output_str << std::endl;
-                }
-                continue;
-            }
+        schedule = Enqueue(lock, item);
+    }
+    if (schedule)
+    {
+        service.Schedule(shared_from_this());
+    }
+}
 
-            const std::set<int>& ignored_set = ignored_packets[{item.connection_state, item.origin}];
-            const bool is_ignored = ignored_set.find(item.msg->GetId()) != ignored_set.end();
-            if (is_ignored)
-            {
-                continue;
-            }
+const bool Logger::IsStatsMode() const
+{
+    return packet_stats != nullptr;
+}
 
-            const std::set<int>& detailed_set = detailed_packets[{item.connection_state, item.origin}];
-            const bool is_detailed = detailed_set.find(item.msg->GetId()) != detailed_set.end();
+void Logger::LogPacketStats(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id,
+    const size_t wire_size, const size_t uncompressed_size)
+{
+    packet_stats->Record(origin, connection_state, id, wire_size, uncompressed_size);
 
-            output << "[" << hours << ":" << min << ":" << sec << ":" << milisec << "] "
-                << (item.origin == Origin::Server ? "[S --> C] " : "[C --> S] ");
-            output << item.msg->GetName();
-            if (is_detailed)
-            {
-                output << "\n" << item.msg->Serialize().serialize(true);
-            }
+    // Don't read the clock for every packet
+    packets_since_stats_check += 1;
+    if (packets_since_stats_check < 256)
+    {
+        return;
+    }
+    packets_since_stats_check = 0;
 
-            const std::string output_str = output.str();
-            log_file << output_str << std::endl;
-            if (log_to_console)
-            {
-                std::cout << output_str << std::endl;
-            }
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - last_packet_stats_dump >= packet_stats_interval)
+    {
+        last_packet_stats_dump = now;
+        LogMessage(packet_stats->ToString(packet_stats_top_n));
+    }
+}
+
+bool Logger::Enqueue(std::unique_lock<std::mutex>& lock, LogItem& item)
+{
+    if (!MakeRoom(lock, item))
+    {
+        return false;
+    }
+
+    if (!session_started)
+    {
+        session_started = true;
+        start_time = std::chrono::system_clock::now();
+        log_format = configuration->log_format;
+    }
+
+    logging_queue.push_back(std::move(item));
+    Metrics::Add(MetricCounter::LogItemsQueued);
 
-            // Every 5 seconds, check if the conf file has changed and reload it if needed
-            std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-            if (now - last_time_checked_log_file > 5)
+    // Already in the service, the thread writing
+    // it will see this item before releasing it
+    if (scheduled)
+    {
+        return false;
+    }
+    scheduled = true;
+    return true;
+}
+
+bool Logger::MakeRoom(std::unique_lock<std::mutex>& lock, LogItem& item)
+{
+    const size_t queue_capacity = configuration->log_queue_capacity;
+    const size_t high_watermark = queue_capacity - queue_capacity / 4;
+    // Items being written are still in memory
+    const size_t queued_items = logging_queue.size() + in_flight_items;
+
+    switch (configuration->log_queue_overflow_policy)
+    {
+    case LogOverflowPolicy::Block:
+        queue_not_full_condition.wait(lock, [this] { return !is_running || logging_queue.size() + in_flight_items < configuration->log_queue_capacity; });
+        return is_running;
+    case LogOverflowPolicy::DropNewest:
+        break;
+    case LogOverflowPolicy::DropDetailedFirst:
+        // Serializing details is the expensive part for the
+        // writing thread, so we stop doing it first
+        if (item.is_detailed && queued_items >= high_watermark)
+        {
+            item.is_detailed = false;
+            dropped_details += 1;
+        }
+        break;
+    case LogOverflowPolicy::Sample:
+        if (queued_items >= high_watermark)
+        {
+            sample_counter = (sample_counter + 1) % configuration->log_queue_sample_rate;
+            if (sample_counter != 0)
             {
-                last_time_checked_log_file = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                LoadConfig(logfile_path);
+                sampled_out_items += 1;
+                Metrics::Add(MetricCounter::LogItemsDropped);
+                return false;
             }
         }
+        break;
     }
+
+    if (queued_items >= queue_capacity)
+    {
+        dropped_items += 1;
+        Metrics::Add(MetricCounter::LogItemsDropped);
+        return false;
+    }
+
+    return true;
 }
 
-void Logger::LoadConfig(const std::string& path)
+const bool Logger::WriteBatch()
 {
-    std::time_t modification_time = GetModifiedTimestamp(path);
-    if (modification_time == -1 ||
-        modification_time == last_time_log_file_modified)
+    std::deque<LogItem> items;
+    unsigned long long batch_dropped_items = 0;
+    unsigned long long batch_dropped_details = 0;
+    unsigned long long batch_sampled_out_items = 0;
+    std::shared_ptr<const Configuration> batch_configuration;
+
     {
-        return;
+        std::lock_guard<std::mutex> lock(log_mutex);
+        if (logging_queue.empty())
+        {
+            scheduled = false;
+            return false;
+        }
+
+        // Take the whole pending batch so the producer
+        // is never blocked while we write to disk
+        items.swap(logging_queue);
+        in_flight_items = items.size();
+        batch_configuration = configuration;
+        if (batch_start_time != start_time)
+        {
+            batch_start_time = start_time;
+            timestamp_formatter.SetStartTime(batch_start_time);
+        }
+
+        batch_dropped_items = dropped_items;
+        batch_dropped_details = dropped_details;
+        batch_sampled_out_items = sampled_out_items;
+        dropped_items = 0;
+        dropped_details = 0;
+        sampled_out_items = 0;
     }
 
-    last_time_log_file_modified = modification_time;
-    std::cout << "Loading updated conf file" << std::endl;
+    // The file is opened by the writing thread
+    // the first time there is something to write
+    if (!log_file.IsOpen())
+    {
+        auto in_time_t = std::chrono::system_clock::to_time_t(batch_start_time);
+        // The service threads can open files at the same time
+        std::tm local_time;
+#ifdef _WIN32
+        localtime_s(&local_time, &in_time_t);
+#else
+        localtime_r(&in_time_t, &local_time);
+#endif
 
-    std::stringstream ss;
-    std::ifstream file;
+        std::stringstream ss;
+        ss << std::put_time(&local_time, "%Y-%m-%d-%H-%M-%S")
+            << "_log";
+
+        log_file.Open(ss.str(), log_format == LogFormat::JsonLines ? ".jsonl" : ".txt", *batch_configuration);
+    }
 
-    bool error = path == "";
-    picojson::value json;
+    if (batch_dropped_items > 0 || batch_dropped_details > 0 || batch_sampled_out_items > 0)
+    {
+        std::stringstream output;
+        output << "Queue overflow: " << batch_dropped_items << " items dropped, "
+            << batch_sampled_out_items << " items sampled out, "
+            << batch_dropped_details << " items logged without details";
+        WriteLoggerMessage(output.str(), *batch_configuration);
+    }
 
-    if (!error)
+    size_t written_items = 0;
+    while (!items.empty())
     {
-        file.open(path);
-        if (!file.is_open())
+        if (items.front().text.empty())
         {
-            std::cerr << "Error trying to open conf file: " << path << "." << std::endl;
-            error = true;
+            WriteLogItem(items.front(), *batch_configuration);
         }
-        if (!error)
+        else
         {
-            ss << file.rdbuf();
-            file.close();
-
-            ss >> json;
-            std::string err = picojson::get_last_error();
+            WriteLoggerMessage(items.front().text, *batch_configuration);
+        }
+        // If the decoder doesn't reference the message anymore, it
+        // can read another packet into it instead of allocating one
+        if (items.front().msg != nullptr && items.front().msg.use_count() == 1)
+        {
+            ReleasedMessage released{ std::move(items.front().msg), items.front().connection_state, items.front().origin };
+            written_messages.push_back(std::move(released));
+        }
+        items.pop_front();
+        Metrics::Add(MetricCounter::LogItemsWritten);
 
-            if (!err.empty())
+        // Give back capacity regularly, not once per item
+        written_items += 1;
+        if (written_items == IN_FLIGHT_RELEASE_STEP || items.empty())
+        {
             {
-                std::cerr << "Error parsing conf file at " << path << ".\n";
-                std::cerr << err << "\n" << std::endl;
-                error = true;
+                std::lock_guard<std::mutex> lock(log_mutex);
+                in_flight_items -= written_items;
             }
-            if (!error)
+            written_items = 0;
+            queue_not_full_condition.notify_all();
+
+            if (!written_messages.empty())
             {
-                if (!json.is<picojson::object>())
+                std::lock_guard<std::mutex> lock(released_mutex);
+                for (size_t i = 0; i < written_messages.size() && released_messages.size() < MAX_RELEASED_MESSAGES; ++i)
                 {
-                    std::cerr << "Error parsing conf file at " << path << "." << std::endl;
-                    error = true;
+                    released_messages.push_back(std::move(written_messages[i]));
                 }
+                has_released_messages.store(true, std::memory_order_release);
             }
+            written_messages.clear();
         }
     }
+    log_file.Flush();
 
-    //Create default conf
-    if (error)
+    // Stay scheduled if something has been queued while we were writing,
+    // the service puts us back at the end of its list
+    std::lock_guard<std::mutex> lock(log_mutex);
+    if (logging_queue.empty())
     {
-        return;
+        scheduled = false;
+        return false;
     }
+    return true;
+}
 
-    const std::map<std::string, ProtocolCraft::ConnectionState> name_mapping = {
-        {"Handshaking", ProtocolCraft::ConnectionState::Handshake},
-        {"Status", ProtocolCraft::ConnectionState::Status},
-        {"Login", ProtocolCraft::ConnectionState::Login},
-        {"Play", ProtocolCraft::ConnectionState::Play}
-    };
-
-    const picojson::value::object& obj = json.get<picojson::object>();
-
-    log_to_console = false;
-    auto log_to_console_value = obj.find("LogToConsole");
-    if (log_to_console_value == obj.end())
-    {
-        log_to_console = false;
-    }
-    else
+void Logger::WriteLogItem(const LogItem& item, const Configuration& conf)
+{
     {
-        log_to_console = log_to_console_value->second.get<bool>();
-    }
+        SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::LogFormatting);
+        char timestamp[TimestampFormatter::MAX_LENGTH];
+        const size_t timestamp_length = timestamp_formatter.Format(conf.timestamp_format, item.date, item.monotonic_date, timestamp);
 
-    for (auto it = name_mapping.begin(); it != name_mapping.end(); ++it)
-    {
-        auto it2 = obj.find(it->first);
-        if (it2 != obj.end())
+        output_line.clear();
+        if (log_format == LogFormat::JsonLines)
         {
-            LoadPacketsFromJson(it2->second, it->second);
+            WriteJsonItem(item, timestamp, timestamp_length);
         }
         else
         {
-            const picojson::value null_value = picojson::value();
-            LoadPacketsFromJson(null_value, it->second);
+            WriteTextItem(item, timestamp, timestamp_length);
         }
     }
+
+    log_file.WriteLine(output_line);
+    if (conf.log_to_console)
+    {
+        std::cout << output_line << std::endl;
+    }
 }
 
-void Logger::LoadPacketsFromJson(const picojson::value& value, const ProtocolCraft::ConnectionState connection_state)
+void Logger::WriteTextItem(const LogItem& item, const char* timestamp, const size_t timestamp_length)
 {
-    ignored_packets[{connection_state, Origin::Client}] = std::set<int>();
-    ignored_packets[{connection_state, Origin::Server}] = std::set<int>();
-    detailed_packets[{connection_state, Origin::Client}] = std::set<int>();
-    detailed_packets[{connection_state, Origin::Server}] = std::set<int>();
+    output_line += '[';
+    output_line.append(timestamp, timestamp_length);
+    output_line += (item.origin == Origin::Server ? "] [S --> C] " : "] [C --> S] ");
 
-    if (value.is<picojson::null>())
+    if (item.msg == nullptr)
     {
+        output_line += "UNKNOWN OR WRONGLY PARSED MESSAGE";
         return;
     }
 
-    if (value.contains("ignored_clientbound"))
+    output_line += item.msg->GetName();
+    if (item.is_detailed)
     {
-        const picojson::object& object2 = value.get<picojson::object>();
-        if (object2.find("ignored_clientbound") != object2.end() && object2.at("ignored_clientbound").is<picojson::array>())
-        {
-            const picojson::array& ignored = object2.at("ignored_clientbound").get<picojson::array>();
-            for (auto i = ignored.begin(); i != ignored.end(); i++)
-            {
-                if (i->is<double>())
-                {
-                    ignored_packets[{connection_state, Origin::Server}].insert(i->get<double>());
-                }
-                else if (i->is<std::string>())
-                {
-                    for (int j = 0; j < 100; ++j)
-                    {
-                        auto msg = ProtocolCraft::MessageFactory::CreateMessageClientbound(j, connection_state);
-                        if (msg && msg->GetName() == i->get<std::string>())
-                        {
-                            ignored_packets[{connection_state, Origin::Server}].insert(j);
-                        }
-                    }
-                }
-            }
-        }
+        output_line += '\n';
+        output_line += item.msg->Serialize().serialize(true);
     }
-    if (value.contains("ignored_serverbound"))
+}
+
+void Logger::WriteJsonItem(const LogItem& item, const char* timestamp, const size_t timestamp_length)
+{
+    JsonWriter writer(output_line);
+
+    writer.StartObject();
+    writer.Key("timestamp");
+    writer.String(timestamp, timestamp_length);
+    writer.Key("session");
+    writer.Integer(session_id);
+    writer.Key("direction");
+    writer.String(item.origin == Origin::Server ? "clientbound" : "serverbound");
+    writer.Key("state");
+    writer.String(ConnectionStateName(item.connection_state));
+
+    if (item.msg == nullptr)
     {
-        const picojson::object& object2 = value.get<picojson::object>();
-        if (object2.find("ignored_serverbound") != object2.end() && object2.at("ignored_serverbound").is<picojson::array>())
-        {
-            const picojson::array& ignored = object2.at("ignored_serverbound").get<picojson::array>();
-            for (auto i = ignored.begin(); i != ignored.end(); i++)
-            {
-                if (i->is<double>())
-                {
-                    ignored_packets[{connection_state, Origin::Client}].insert(i->get<double>());
-                }
-                else if (i->is<std::string>())
-                {
-                    for (int j = 0; j < 100; ++j)
-                    {
-                        auto msg = ProtocolCraft::MessageFactory::CreateMessageServerbound(j, connection_state);
-                        if (msg && msg->GetName() == i->get<std::string>())
-                        {
-                            ignored_packets[{connection_state, Origin::Client}].insert(j);
-                        }
-                    }
-                }
-            }
-        }
+        writer.Key("id");
+        writer.Null();
+        writer.Key("name");
+        writer.Null();
     }
-    if (value.contains("detailed_clientbound"))
+    else
     {
-        const picojson::object& object2 = value.get<picojson::object>();
-        if (object2.find("detailed_clientbound") != object2.end() && object2.at("detailed_clientbound").is<picojson::array>())
+        writer.Key("id");
+        writer.Integer(item.msg->GetId());
+        writer.Key("name");
+        writer.String(item.msg->GetName());
+        if (item.is_detailed)
         {
-            const picojson::array& ignored = object2.at("detailed_clientbound").get<picojson::array>();
-            for (auto i = ignored.begin(); i != ignored.end(); i++)
-            {
-                if (i->is<double>())
-                {
-                    detailed_packets[{connection_state, Origin::Client}].insert(i->get<double>());
-                }
-                else if (i->is<std::string>())
-                {
-                    for (int j = 0; j < 100; ++j)
-                    {
-                        auto msg = ProtocolCraft::MessageFactory::CreateMessageClientbound(j, connection_state);
-                        if (msg && msg->GetName() == i->get<std::string>())
-                        {
-                            detailed_packets[{connection_state, Origin::Server}].insert(j);
-                        }
-                    }
-                }
-            }
+            // protocolCraft can only give us the content as a picojson
+            // value, but we can at least stream it without a temporary string
+            writer.Key("fields");
+            writer.Value(item.msg->Serialize());
         }
     }
-    if (value.contains("detailed_serverbound"))
+    writer.EndObject();
+}
+
+void Logger::WriteLoggerMessage(const std::string& message, const Configuration& conf)
+{
+    output_line.clear();
+    if (log_format == LogFormat::JsonLines)
     {
-        const picojson::object& object2 = value.get<picojson::object>();
-        if (object2.find("detailed_serverbound") != object2.end() && object2.at("detailed_serverbound").is<picojson::array>())
-        {
-            const picojson::array& ignored = object2.at("detailed_serverbound").get<picojson::array>();
-            for (auto i = ignored.begin(); i != ignored.end(); i++)
-            {
-                if (i->is<double>())
-                {
-                    detailed_packets[{connection_state, Origin::Client}].insert(i->get<double>());
-                }
-                else if (i->is<std::string>())
-                {
-                    for (int j = 0; j < 100; ++j)
-                    {
-                        auto msg = ProtocolCraft::MessageFactory::CreateMessageServerbound(j, connection_state);
-                        if (msg && msg->GetName() == i->get<std::string>())
-                        {
-                            detailed_packets[{connection_state, Origin::Client}].insert(j);
-                        }
-                    }
-                }
-            }
-        }
+        JsonWriter writer(output_line);
+        writer.StartObject();
+        writer.Key("session");
+        writer.Integer(session_id);
+        writer.Key("logger");
+        writer.String(message);
+        writer.EndObject();
+    }
+    else
+    {
+        output_line += "[Logger] ";
+        output_line += message;
+    }
+
+    log_file.WriteLine(output_line);
+    if (conf.log_to_console)
+    {
+        std::cout << output_line << std::endl;
     }
 }
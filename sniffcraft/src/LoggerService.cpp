@@ -0,0 +1,99 @@
+#include "sniffcraft/LoggerService.hpp"
+#include "sniffcraft/Logger.hpp"
+
+LoggerService::LoggerService(const size_t num_threads)
+{
+    busy_threads = 0;
+    is_running = true;
+    for (size_t i = 0; i < num_threads; ++i)
+    {
+        threads.push_back(std::thread(&LoggerService::WorkLoop, this));
+    }
+}
+
+LoggerService::~LoggerService()
+{
+    Stop(std::chrono::milliseconds(0));
+}
+
+const bool LoggerService::Stop(const std::chrono::milliseconds& timeout)
+{
+    bool drained = false;
+    // Released outside of the lock, the last
+    // reference of a logger closes its file
+    std::deque<std::shared_ptr<Logger> > abandoned_loggers;
+    {
+        std::unique_lock<std::mutex> lock(ready_mutex);
+        drained = idle_condition.wait_for(lock, timeout, [this] { return ready_loggers.empty() && busy_threads == 0; });
+        is_running = false;
+        abandoned_loggers.swap(ready_loggers);
+    }
+    ready_condition.notify_all();
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        if (threads[i].joinable())
+        {
+            threads[i].join();
+        }
+    }
+
+    return drained;
+}
+
+void LoggerService::Schedule(const std::shared_ptr<Logger>& logger)
+{
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        if (!is_running)
+        {
+            return;
+        }
+        ready_loggers.push_back(logger);
+    }
+    ready_condition.notify_one();
+}
+
+void LoggerService::WorkLoop()
+{
+    while (true)
+    {
+        std::shared_ptr<Logger> logger;
+        {
+            std::unique_lock<std::mutex> lock(ready_mutex);
+            ready_condition.wait(lock, [this] { return !is_running || !ready_loggers.empty(); });
+            if (!is_running)
+            {
+                return;
+            }
+            logger = ready_loggers.front();
+            ready_loggers.pop_front();
+            busy_threads += 1;
+        }
+
+        const bool more_items = logger->WriteBatch();
+
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lock(ready_mutex);
+            busy_threads -= 1;
+            // Sessions with more items go back at the end of the
+            // list, so a busy one doesn't delay the others
+            if (more_items && is_running)
+            {
+                ready_loggers.push_back(logger);
+            }
+            idle = ready_loggers.empty() && busy_threads == 0;
+        }
+        if (more_items)
+        {
+            ready_condition.notify_one();
+        }
+        if (idle)
+        {
+            idle_condition.notify_all();
+        }
+        // The last reference of a stopped session can be released
+        // here, its file is then closed by this thread
+    }
+}
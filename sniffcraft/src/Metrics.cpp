@@ -0,0 +1,161 @@
+#include "sniffcraft/Metrics.hpp"
+#include "sniffcraft/ThreadShards.hpp"
+
+#include <atomic>
+#include <sstream>
+#include <vector>
+
+// Enough for all the packet ids of the supported versions
+const int MAX_METRICS_PACKET_ID = 256;
+const int NUM_METRICS_CONNECTION_STATE = 4;
+
+struct MetricsShard
+{
+    MetricsShard()
+    {
+        for (int i = 0; i < static_cast<int>(MetricCounter::NUM_METRIC_COUNTER); ++i)
+        {
+            counters[i].store(0, std::memory_order_relaxed);
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            for (int j = 0; j < NUM_METRICS_CONNECTION_STATE; ++j)
+            {
+                for (int k = 0; k < MAX_METRICS_PACKET_ID; ++k)
+                {
+                    packets[i][j][k].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    std::atomic<unsigned long long> counters[static_cast<int>(MetricCounter::NUM_METRIC_COUNTER)];
+    std::atomic<unsigned long long> packets[2][NUM_METRICS_CONNECTION_STATE][MAX_METRICS_PACKET_ID];
+};
+
+MetricsShard& GetThreadShard()
+{
+    return ThreadShards<MetricsShard>::Local();
+}
+
+// Only the owner thread writes in a shard, so no need for a locked add
+inline void Increment(std::atomic<unsigned long long>& value, const unsigned long long increment)
+{
+    value.store(value.load(std::memory_order_relaxed) + increment, std::memory_order_relaxed);
+}
+
+void Metrics::Add(const MetricCounter counter, const unsigned long long value)
+{
+    Increment(GetThreadShard().counters[static_cast<int>(counter)], value);
+}
+
+void Metrics::AddPacket(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id)
+{
+    const int state = static_cast<int>(connection_state);
+    if (state < 0 || state >= NUM_METRICS_CONNECTION_STATE || id < 0 || id >= MAX_METRICS_PACKET_ID)
+    {
+        return;
+    }
+    Increment(GetThreadShard().packets[static_cast<int>(origin)][state][id], 1);
+}
+
+const std::string Metrics::Scrape()
+{
+    std::vector<unsigned long long> counters(static_cast<int>(MetricCounter::NUM_METRIC_COUNTER), 0);
+    std::vector<unsigned long long> packets(2 * NUM_METRICS_CONNECTION_STATE * MAX_METRICS_PACKET_ID, 0);
+
+    ThreadShards<MetricsShard>::ForEach([&](const MetricsShard& shard)
+        {
+            for (size_t i = 0; i < counters.size(); ++i)
+            {
+                counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+            }
+            for (int i = 0; i < 2; ++i)
+            {
+                for (int j = 0; j < NUM_METRICS_CONNECTION_STATE; ++j)
+                {
+                    for (int k = 0; k < MAX_METRICS_PACKET_ID; ++k)
+                    {
+                        packets[(i * NUM_METRICS_CONNECTION_STATE + j) * MAX_METRICS_PACKET_ID + k] += shard.packets[i][j][k].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+
+    auto get = [&counters](const MetricCounter c) { return counters[static_cast<int>(c)]; };
+    // Counters are read in no particular order, a difference could be briefly negative
+    auto difference = [](const unsigned long long a, const unsigned long long b) { return a > b ? a - b : 0ULL; };
+
+    std::stringstream output;
+
+    output << "# HELP sniffcraft_active_sessions Sessions currently proxied\n"
+        << "# TYPE sniffcraft_active_sessions gauge\n"
+        << "sniffcraft_active_sessions " << difference(get(MetricCounter::SessionsOpened), get(MetricCounter::SessionsClosed)) << "\n";
+
+    output << "# HELP sniffcraft_sessions_total Sessions started since launch\n"
+        << "# TYPE sniffcraft_sessions_total counter\n"
+        << "sniffcraft_sessions_total " << get(MetricCounter::SessionsOpened) << "\n";
+
+    output << "# HELP sniffcraft_bytes_total Bytes received, per direction\n"
+        << "# TYPE sniffcraft_bytes_total counter\n"
+        << "sniffcraft_bytes_total{direction=\"serverbound\"} " << get(MetricCounter::BytesFromClient) << "\n"
+        << "sniffcraft_bytes_total{direction=\"clientbound\"} " << get(MetricCounter::BytesFromServer) << "\n";
+
+    const char* state_names[NUM_METRICS_CONNECTION_STATE] = { "handshaking", "status", "login", "play" };
+    output << "# HELP sniffcraft_packets_total Packets received, per direction, state and id\n"
+        << "# TYPE sniffcraft_packets_total counter\n";
+    for (int i = 0; i < 2; ++i)
+    {
+        const char* direction = static_cast<Origin>(i) == Origin::Server ? "clientbound" : "serverbound";
+        for (int j = 0; j < NUM_METRICS_CONNECTION_STATE; ++j)
+        {
+            for (int k = 0; k < MAX_METRICS_PACKET_ID; ++k)
+            {
+                const unsigned long long count = packets[(i * NUM_METRICS_CONNECTION_STATE + j) * MAX_METRICS_PACKET_ID + k];
+                if (count > 0)
+                {
+                    output << "sniffcraft_packets_total{direction=\"" << direction << "\",state=\"" << state_names[j]
+                        << "\",id=\"" << k << "\"} " << count << "\n";
+                }
+            }
+        }
+    }
+
+    output << "# HELP sniffcraft_decompress_seconds_total Time spent decompressing packets\n"
+        << "# TYPE sniffcraft_decompress_seconds_total counter\n"
+        << "sniffcraft_decompress_seconds_total " << get(MetricCounter::DecompressNanoseconds) / 1e9 << "\n";
+
+    output << "# HELP sniffcraft_decompress_total Decompressed packets\n"
+        << "# TYPE sniffcraft_decompress_total counter\n"
+        << "sniffcraft_decompress_total " << get(MetricCounter::DecompressCalls) << "\n";
+
+    output << "# HELP sniffcraft_parse_exceptions_total Packets that could not be parsed\n"
+        << "# TYPE sniffcraft_parse_exceptions_total counter\n"
+        << "sniffcraft_parse_exceptions_total " << get(MetricCounter::ParseExceptions) << "\n";
+
+    output << "# HELP sniffcraft_log_queue_depth Items waiting to be written, all sessions\n"
+        << "# TYPE sniffcraft_log_queue_depth gauge\n"
+        << "sniffcraft_log_queue_depth " << difference(get(MetricCounter::LogItemsQueued), get(MetricCounter::LogItemsWritten)) << "\n";
+
+    output << "# HELP sniffcraft_log_dropped_items_total Items dropped because a log queue was full\n"
+        << "# TYPE sniffcraft_log_dropped_items_total counter\n"
+        << "sniffcraft_log_dropped_items_total " << get(MetricCounter::LogItemsDropped) << "\n";
+
+    output << "# HELP sniffcraft_dns_cache_hits_total Upstream address resolutions served from cache\n"
+        << "# TYPE sniffcraft_dns_cache_hits_total counter\n"
+        << "sniffcraft_dns_cache_hits_total " << get(MetricCounter::DNSCacheHits) << "\n";
+
+    output << "# HELP sniffcraft_dns_cache_misses_total Upstream address resolutions not in cache\n"
+        << "# TYPE sniffcraft_dns_cache_misses_total counter\n"
+        << "sniffcraft_dns_cache_misses_total " << get(MetricCounter::DNSCacheMisses) << "\n";
+
+    output << "# HELP sniffcraft_rejected_connections_total Connections refused by the admission limits\n"
+        << "# TYPE sniffcraft_rejected_connections_total counter\n"
+        << "sniffcraft_rejected_connections_total " << get(MetricCounter::ConnectionsRejected) << "\n";
+
+    output << "# HELP sniffcraft_decode_dropped_packets_total Packets forwarded but not decoded because a session decode queue was full\n"
+        << "# TYPE sniffcraft_decode_dropped_packets_total counter\n"
+        << "sniffcraft_decode_dropped_packets_total " << get(MetricCounter::DecodePacketsDropped) << "\n";
+
+    return output.str();
+}
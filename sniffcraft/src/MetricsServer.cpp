@@ -0,0 +1,102 @@
+#include "sniffcraft/MetricsServer.hpp"
+#include "sniffcraft/Metrics.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+// Requests are only a request line and a few headers
+const size_t MAX_REQUEST_SIZE = 8192;
+
+// One HTTP request/response, kept alive by the handlers
+class MetricsConnection : public std::enable_shared_from_this<MetricsConnection>
+{
+public:
+    MetricsConnection(asio::ip::tcp::socket socket) : socket_(std::move(socket)), request_(MAX_REQUEST_SIZE)
+    {
+
+    }
+
+    void Start()
+    {
+        asio::async_read_until(socket_, request_, "\r\n\r\n",
+            std::bind(&MetricsConnection::handle_read, shared_from_this(),
+                std::placeholders::_1, std::placeholders::_2));
+    }
+
+private:
+    void handle_read(const asio::error_code& ec, const size_t)
+    {
+        if (ec)
+        {
+            // Including not_found: no end of headers in MAX_REQUEST_SIZE bytes
+            asio::error_code ignored_ec;
+            socket_.close(ignored_ec);
+            return;
+        }
+
+        std::istream request_stream(&request_);
+        std::string method;
+        std::string path;
+        request_stream >> method >> path;
+
+        std::string body;
+        std::string status;
+        if (method == "GET" && (path == "/metrics" || path == "/"))
+        {
+            status = "200 OK";
+            body = Metrics::Scrape();
+        }
+        else
+        {
+            status = "404 Not Found";
+            body = "Not found\n";
+        }
+
+        response_ = "HTTP/1.1 " + status + "\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+
+        asio::async_write(socket_, asio::buffer(response_),
+            std::bind(&MetricsConnection::handle_write, shared_from_this(),
+                std::placeholders::_1));
+    }
+
+    void handle_write(const asio::error_code&)
+    {
+        asio::error_code ignored_ec;
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ignored_ec);
+        socket_.close(ignored_ec);
+    }
+
+private:
+    asio::ip::tcp::socket socket_;
+    asio::streambuf request_;
+    std::string response_;
+};
+
+MetricsServer::MetricsServer(asio::io_context& io_context, const unsigned short port) :
+    io_context_(io_context),
+    acceptor_(io_context, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port)),
+    next_socket_(io_context)
+{
+    start_accept();
+}
+
+void MetricsServer::start_accept()
+{
+    acceptor_.async_accept(next_socket_,
+        std::bind(&MetricsServer::handle_accept, this,
+            std::placeholders::_1));
+}
+
+void MetricsServer::handle_accept(const asio::error_code& ec)
+{
+    if (!ec)
+    {
+        std::make_shared<MetricsConnection>(std::move(next_socket_))->Start();
+    }
+    next_socket_ = asio::ip::tcp::socket(io_context_);
+    start_accept();
+}
@@ -1,24 +1,130 @@
 #include "sniffcraft/MinecraftProxy.hpp"
-#include "sniffcraft/Compression.hpp"
+#include "sniffcraft/ConfigWatcher.hpp"
+#include "sniffcraft/DNSCache.hpp"
+#include "sniffcraft/Metrics.hpp"
+#include "sniffcraft/Profiler.hpp"
+#include "sniffcraft/SocketTuning.hpp"
 
 #include <protocolCraft/BinaryReadWrite.hpp>
-#include <protocolCraft/MessageFactory.hpp>
 
+#include <array>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <atomic>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::atomic<unsigned long long> next_session_id(0);
+
+#ifdef __linux__
+// Max bytes moved by one splice call
+const size_t SPLICE_CHUNK_SIZE = 64 * 1024;
+// Max bytes read by one SpliceStep before letting other sessions run
+const size_t SPLICE_STEP_BUDGET = 1024 * 1024;
+#endif
+
+// Max client bytes kept while the server is not connected. Only the
+// Handshake and the Login Start/Status request can legitimately be there
+const size_t MAX_PRECONNECT_DATA = 4096;
+
+// Id of a packet forwarded before being decoded, for the latency
+// stats. data is after the packet length. -1 if it can't be read
+// without decompression (compressed packets) or is invalid
+const int PeekPacketId(const unsigned char* data, const size_t length, const int compression_threshold)
+{
+    int id = -1;
+    if (compression_threshold < 0)
+    {
+        return DecodeVarInt(data, length, id) > 0 ? id : -1;
+    }
+
+    int data_length = 0;
+    const int data_length_size = DecodeVarInt(data, length, data_length);
+    if (data_length_size <= 0)
+    {
+        return -1;
+    }
+    // Compressed packets are not inflated on the io thread
+    if (data_length != 0)
+    {
+        return -1;
+    }
+    return DecodeVarInt(data + data_length_size, length - data_length_size, id) > 0 ? id : -1;
+}
 
-MinecraftProxy::MinecraftProxy(asio::io_context& io_context, const std::string& logconf_path) :
+MinecraftProxy::MinecraftProxy(asio::io_context& io_context, asio::ip::tcp::socket client_socket, const ConfigWatcher& config_watcher,
+    asio::thread_pool* decode_pool, const HostRouter* host_router, TimerWheel* timer_wheel, AdmissionControl* admission_control,
+    LoggerService& logger_service) :
     io_context_(io_context),
-    client_socket_(io_context),
+    config_watcher_(config_watcher),
+    client_socket_(std::move(client_socket)),
     server_socket_(io_context),
-    logger(logconf_path)
+    host_router_(host_router),
+    admission_control_(admission_control),
+    timer_wheel_(timer_wheel),
+    session_id(next_session_id++),
+    decoder(std::make_shared<PacketDecoder>(config_watcher, session_id, decode_pool, logger_service))
 {
     connection_state = ProtocolCraft::ConnectionState::Handshake;
     client_closed = false;
     server_closed = false;
+    pending_operations_ = 0;
+    server_connected_ = false;
+
+    output_client_data_packets_ = 0;
+    output_client_buffer_packets_ = 0;
+    output_server_data_packets_ = 0;
+    output_server_buffer_packets_ = 0;
 
     compression_threshold = -1;
+
+#ifdef __linux__
+    splice_enabled_ = false;
+    for (int i = 0; i < 2; ++i)
+    {
+        splice_legs_[i].pipe_fds[0] = -1;
+        splice_legs_[i].pipe_fds[1] = -1;
+        splice_legs_[i].in_pipe = 0;
+        splice_legs_[i].pending = false;
+    }
+#endif
+
+    std::shared_ptr<const Configuration> conf = config_watcher.GetConfiguration();
+    client_socket_options_ = conf->client_socket_options;
+    server_socket_options_ = conf->server_socket_options;
+
+    handshake_timeout_ticks_ = 0;
+    login_timeout_ticks_ = 0;
+    idle_timeout_ticks_ = 0;
+    phase_deadline_ = 0;
+    last_activity_ = 0;
+    if (timer_wheel_ != nullptr)
+    {
+        handshake_timeout_ticks_ = timer_wheel_->Ticks(conf->handshake_timeout);
+        login_timeout_ticks_ = timer_wheel_->Ticks(conf->login_timeout);
+        idle_timeout_ticks_ = timer_wheel_->Ticks(conf->idle_timeout);
+        if (handshake_timeout_ticks_ == 0 && login_timeout_ticks_ == 0 && idle_timeout_ticks_ == 0)
+        {
+            timer_wheel_ = nullptr;
+        }
+        else
+        {
+            timeout_entry_.callback = std::bind(&MinecraftProxy::handle_timeout, this);
+        }
+    }
+    if (conf->latency_stats_enabled)
+    {
+        latency_stats_ = std::unique_ptr<LatencyStats>(new LatencyStats());
+        latency_stats_delta_ = std::unique_ptr<LatencyStats>(new LatencyStats());
+        last_latency_dump_ = std::chrono::steady_clock::now();
+        latency_dump_interval_ = conf->latency_dump_interval;
+        latency_top_packets_ = conf->latency_top_packets;
+    }
 }
 
 asio::ip::tcp::socket& MinecraftProxy::ClientSocket()
@@ -31,34 +137,95 @@ asio::ip::tcp::socket& MinecraftProxy::ServerSocket()
     return server_socket_;
 }
 
-void MinecraftProxy::Start(const std::string& server_address, const unsigned short server_port)
+void MinecraftProxy::Start(const std::string& server_address, const unsigned short server_port, const asio::ip::address& client_address)
 {
-    std::cout << "Starting new proxy to " << server_address << ":" << server_port << std::endl;
+    client_address_ = client_address;
     server_ip_ = server_address;
     server_port_ = server_port;
+    Metrics::Add(MetricCounter::SessionsOpened);
+    ApplySocketOptions(client_socket_, client_socket_options_, "client");
+
+    if (timer_wheel_ != nullptr)
+    {
+        last_activity_ = timer_wheel_->CurrentTick();
+        phase_deadline_ = handshake_timeout_ticks_ > 0 ? last_activity_ + handshake_timeout_ticks_ : 0;
+        ScheduleTimeout();
+    }
+
+    if (host_router_ != nullptr)
+    {
+        // The server will be chosen when the Handshake is parsed
+        std::cout << "Starting new proxy, waiting for the handshake to choose the server" << std::endl;
+        pending_operations_ += 1;
+        client_socket_.async_read_some(asio::buffer(input_client_buffer_.data(), MAX_LENGTH),
+            std::bind(&MinecraftProxy::handle_client_read, this,
+                std::placeholders::_1, std::placeholders::_2));
+        return;
+    }
+
+    std::cout << "Starting new proxy to " << server_address << ":" << server_port << std::endl;
+    ConnectToServer();
+}
 
-    // Try to connect to remote server
-    asio::ip::tcp::resolver resolver(io_context_);
-    asio::ip::tcp::resolver::query query(server_ip_, std::to_string(server_port_));
-    asio::ip::tcp::resolver::iterator iterator = resolver.resolve(query);
+void MinecraftProxy::ConnectToServer()
+{
+    pending_operations_ += 1;
+    DNSCache::GetInstance().AsyncResolve(io_context_, server_ip_, server_port_,
+        std::bind(&MinecraftProxy::handle_server_resolve, this, std::placeholders::_1, std::placeholders::_2));
+}
 
-    asio::async_connect(server_socket_, iterator,
-        std::bind(&MinecraftProxy::handle_server_connect, this, std::placeholders::_1));
+void MinecraftProxy::handle_server_resolve(const asio::error_code& ec, const std::vector<asio::ip::tcp::endpoint>& endpoints)
+{
+    if (FinishOperation())
+    {
+        return;
+    }
+
+    if (!ec)
+    {
+        // Try to connect to remote server
+        pending_operations_ += 1;
+        asio::async_connect(server_socket_, endpoints,
+            std::bind(&MinecraftProxy::handle_server_connect, this, std::placeholders::_1));
+    }
+    else
+    {
+        std::cerr << "Can't resolve " << server_ip_ << ":" << server_port_ << " (" << ec.message() << ")" << std::endl;
+        Close();
+    }
 }
 
 void MinecraftProxy::handle_server_connect(const asio::error_code& ec)
 {
+    if (FinishOperation())
+    {
+        return;
+    }
+
     if (!ec)
     {
+        ApplySocketOptions(server_socket_, server_socket_options_, "server");
+
         // Read from server
+        pending_operations_ += 1;
         server_socket_.async_read_some(asio::buffer(input_server_buffer_.data(), MAX_LENGTH),
             std::bind(&MinecraftProxy::handle_server_read, this,
                 std::placeholders::_1, std::placeholders::_2));
 
-        // Read from client
-        client_socket_.async_read_some(asio::buffer(input_client_buffer_.data(), MAX_LENGTH),
-            std::bind(&MinecraftProxy::handle_client_read, this,
-                std::placeholders::_1, std::placeholders::_2));
+        // Read from client, already started if routed by hostname
+        if (host_router_ == nullptr)
+        {
+            pending_operations_ += 1;
+            client_socket_.async_read_some(asio::buffer(input_client_buffer_.data(), MAX_LENGTH),
+                std::bind(&MinecraftProxy::handle_client_read, this,
+                    std::placeholders::_1, std::placeholders::_2));
+        }
+
+        // Send what the client sent while connecting
+        output_server_mutex_.lock();
+        server_connected_ = true;
+        StartWrite(Origin::Server);
+        output_server_mutex_.unlock();
     }
     else
     {
@@ -68,10 +235,36 @@ void MinecraftProxy::handle_server_connect(const asio::error_code& ec)
 
 void MinecraftProxy::handle_server_read(const asio::error_code& ec, const size_t& bytes_transferred)
 {
+    if (FinishOperation())
+    {
+        return;
+    }
+
     if (!ec)
     {
-        ExtractPacketFromIncomingData(Origin::Server, bytes_transferred);
+        Metrics::Add(MetricCounter::BytesFromServer, bytes_transferred);
+        if (timer_wheel_ != nullptr)
+        {
+            last_activity_ = timer_wheel_->CurrentTick();
+        }
+        if (server_socket_options_.quickack)
+        {
+            RearmQuickAck(server_socket_);
+        }
+        if (!ExtractPacketFromIncomingData(Origin::Server, bytes_transferred, std::chrono::steady_clock::now()))
+        {
+            Close();
+            return;
+        }
 
+#ifdef __linux__
+        if (splice_enabled_ && StartSplice(Origin::Server))
+        {
+            return;
+        }
+#endif
+
+        pending_operations_ += 1;
         server_socket_.async_read_some(asio::buffer(input_server_buffer_.data(), MAX_LENGTH),
             std::bind(&MinecraftProxy::handle_server_read, this,
                 std::placeholders::_1, std::placeholders::_2));
@@ -84,19 +277,35 @@ void MinecraftProxy::handle_server_read(const asio::error_code& ec, const size_t
 
 void MinecraftProxy::handle_client_write(const asio::error_code& ec)
 {
+    if (FinishOperation())
+    {
+        return;
+    }
+
     if (!ec)
     {
         output_client_mutex_.lock();
-        output_client_data_.pop_front();
-
-        if (!output_client_data_.empty())
+        for (size_t i = 0; i < output_client_buffer_packets_; ++i)
         {
-            output_client_buffer_ = output_client_data_.front();
-            asio::async_write(client_socket_, asio::buffer(output_client_buffer_.data(), output_client_buffer_.size()),
-                std::bind(&MinecraftProxy::handle_client_write, this,
-                    std::placeholders::_1));
+            RecordWrittenPacket(Origin::Client);
         }
+        output_client_buffer_.clear();
+        output_client_buffer_packets_ = 0;
+
+        StartWrite(Origin::Client);
+#ifdef __linux__
+        // Everything read before the switch has been written
+        const bool start_splice = splice_legs_[static_cast<int>(Origin::Server)].pending && output_client_buffer_.empty();
+#endif
         output_client_mutex_.unlock();
+
+#ifdef __linux__
+        if (start_splice)
+        {
+            splice_legs_[static_cast<int>(Origin::Server)].pending = false;
+            SpliceStep(Origin::Server);
+        }
+#endif
     }
     else
     {
@@ -106,10 +315,36 @@ void MinecraftProxy::handle_client_write(const asio::error_code& ec)
 
 void MinecraftProxy::handle_client_read(const asio::error_code& ec, const size_t& bytes_transferred)
 {
+    if (FinishOperation())
+    {
+        return;
+    }
+
     if (!ec)
     {
-        ExtractPacketFromIncomingData(Origin::Client, bytes_transferred);
+        Metrics::Add(MetricCounter::BytesFromClient, bytes_transferred);
+        if (timer_wheel_ != nullptr)
+        {
+            last_activity_ = timer_wheel_->CurrentTick();
+        }
+        if (client_socket_options_.quickack)
+        {
+            RearmQuickAck(client_socket_);
+        }
+        if (!ExtractPacketFromIncomingData(Origin::Client, bytes_transferred, std::chrono::steady_clock::now()))
+        {
+            Close();
+            return;
+        }
+
+#ifdef __linux__
+        if (splice_enabled_ && StartSplice(Origin::Client))
+        {
+            return;
+        }
+#endif
 
+        pending_operations_ += 1;
         client_socket_.async_read_some(asio::buffer(input_client_buffer_.data(), MAX_LENGTH),
             std::bind(&MinecraftProxy::handle_client_read, this,
                 std::placeholders::_1, std::placeholders::_2));
@@ -122,19 +357,35 @@ void MinecraftProxy::handle_client_read(const asio::error_code& ec, const size_t
 
 void MinecraftProxy::handle_server_write(const asio::error_code& ec)
 {
+    if (FinishOperation())
+    {
+        return;
+    }
+
     if (!ec)
     {
         output_server_mutex_.lock();
-        output_server_data_.pop_front();
-
-        if (!output_server_data_.empty())
+        for (size_t i = 0; i < output_server_buffer_packets_; ++i)
         {
-            output_server_buffer_ = output_server_data_.front();
-            asio::async_write(server_socket_, asio::buffer(output_server_buffer_.data(), output_server_buffer_.size()),
-                std::bind(&MinecraftProxy::handle_server_write, this,
-                    std::placeholders::_1));
+            RecordWrittenPacket(Origin::Server);
         }
+        output_server_buffer_.clear();
+        output_server_buffer_packets_ = 0;
+
+        StartWrite(Origin::Server);
+#ifdef __linux__
+        // Everything read before the switch has been written
+        const bool start_splice = splice_legs_[static_cast<int>(Origin::Client)].pending && output_server_buffer_.empty();
+#endif
         output_server_mutex_.unlock();
+
+#ifdef __linux__
+        if (start_splice)
+        {
+            splice_legs_[static_cast<int>(Origin::Client)].pending = false;
+            SpliceStep(Origin::Client);
+        }
+#endif
     }
     else
     {
@@ -149,178 +400,501 @@ void MinecraftProxy::Close()
         return;
     }
 
+    // Pending operations complete with operation_aborted
     if (client_socket_.is_open())
     {
         client_socket_.close();
-        client_closed = true;
     }
+    client_closed = true;
 
     if (server_socket_.is_open())
     {
         server_socket_.close();
-        server_closed = true;
     }
+    server_closed = true;
 
+    if (latency_stats_ != nullptr)
+    {
+        DumpLatencyStats();
+    }
+
+    if (timer_wheel_ != nullptr)
+    {
+        timer_wheel_->Cancel(timeout_entry_);
+    }
+
+    if (admission_control_ != nullptr)
+    {
+        admission_control_->Release(client_address_);
+    }
+
+#ifdef __linux__
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int j = 0; j < 2; ++j)
+        {
+            if (splice_legs_[i].pipe_fds[j] != -1)
+            {
+                close(splice_legs_[i].pipe_fds[j]);
+                splice_legs_[i].pipe_fds[j] = -1;
+            }
+        }
+    }
+#endif
+
+    Metrics::Add(MetricCounter::SessionsClosed);
     std::cout << "Session closed" << std::endl;
-    
-    delete this;
+
+    if (pending_operations_ == 0)
+    {
+        delete this;
+    }
 }
 
-void MinecraftProxy::ExtractPacketFromIncomingData(const Origin from, const size_t& bytes_transferred)
+const bool MinecraftProxy::FinishOperation()
+{
+    const unsigned int remaining = --pending_operations_;
+    if (!client_closed || !server_closed)
+    {
+        return false;
+    }
+    if (remaining == 0)
+    {
+        delete this;
+    }
+    return true;
+}
+
+const bool MinecraftProxy::ExtractPacketFromIncomingData(const Origin from, const size_t& bytes_transferred, const std::chrono::steady_clock::time_point& read_time)
 {
     const std::array<unsigned char, MAX_LENGTH>& src_buffer = (from == Origin::Server) ? input_server_buffer_ : input_client_buffer_;
     std::vector<unsigned char>& src_data = (from == Origin::Server) ? input_server_data : input_client_data_;
-    std::deque<std::vector<unsigned char> >& output_dst_data = (from == Origin::Server) ? output_client_data_ : output_server_data_;
+    std::vector<unsigned char>& output_dst_data = (from == Origin::Server) ? output_client_data_ : output_server_data_;
+    size_t& output_dst_packets = (from == Origin::Server) ? output_client_data_packets_ : output_server_data_packets_;
     std::mutex& output_data_mutex = (from == Origin::Server) ? output_client_mutex_ : output_server_mutex_;
-    std::vector<unsigned char>& output_buffer_ = (from == Origin::Server) ? output_client_buffer_ : output_server_buffer_;
     std::vector<unsigned char>& replacement_data = (from == Origin::Server) ? server_replacement_data : client_replacement_data;
+    std::deque<PacketTiming>& output_dst_timings = (from == Origin::Server) ? output_client_timings_ : output_server_timings_;
+    std::vector<FrameSpan>& frame_spans = (from == Origin::Server) ? server_frame_spans : client_frame_spans;
 
-    src_data.insert(std::end(src_data), std::begin(src_buffer), std::begin(src_buffer) + bytes_transferred);
-
-    while (src_data.size() != 0)
+    // Find all the complete packets at once, src_data is
+    // only shifted once they are all processed
+    size_t consumed = 0;
     {
-        std::vector<unsigned char>::const_iterator read_iter = src_data.begin();
-        size_t max_length = src_data.size();
-        int packet_length = 0;
+        SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::Framing);
+        src_data.insert(std::end(src_data), std::begin(src_buffer), std::begin(src_buffer) + bytes_transferred);
+        consumed = ScanFrames(src_data.data(), src_data.size(), frame_spans);
+    }
 
-        // We need a try catch in case all the bytes of 
-        // the varint are not in this buffer
-        try
-        {
-            packet_length = ProtocolCraft::ReadVarInt(read_iter, max_length);
-        }
-        catch (const std::exception&)
+    // Play packets decoded on the pool, created with the first one
+    std::shared_ptr<DecodeBatch> decode_batch;
+
+    for (size_t i = 0; i < frame_spans.size(); ++i)
+    {
+        const FrameSpan& span = frame_spans[i];
+        std::vector<unsigned char>::const_iterator packet_start = src_data.begin() + span.offset;
+        std::vector<unsigned char>::const_iterator read_iter = packet_start + span.header_length;
+        const size_t frame_size = span.header_length + span.length;
+        size_t parse_max_size = span.length;
+
+        PacketTiming timing;
+        if (latency_stats_ != nullptr)
         {
-            break;
+            timing.read = read_time;
+            timing.framed = std::chrono::steady_clock::now();
+            timing.connection_state = connection_state;
         }
 
-        int bytes_read = std::distance<std::vector<unsigned char>::const_iterator>(std::begin(src_data), read_iter);
-        
-        if (packet_length > 0 && src_data.size() >= bytes_read + packet_length)
+        replacement_data.clear();
+        int packet_id = -1;
+        bool decoded = true;
+        // Play packets are never rewritten and don't change the
+        // proxy state, they don't need to be decoded before forwarding
+        if (decoder->HasDecodePool() && connection_state == ProtocolCraft::ConnectionState::Play)
         {
-            size_t parse_max_size = packet_length;
-
-            replacement_data.clear();
-            ParsePacket(from, read_iter, parse_max_size);
-
-            std::vector<unsigned char> output_packet;
-            if (replacement_data.size() == 0)
+            if (decode_batch == nullptr)
             {
-                output_packet = std::vector<unsigned char>(std::begin(src_data), std::begin(src_data) + bytes_read + packet_length);
+                decode_batch = std::make_shared<DecodeBatch>();
+                decode_batch->origin = from;
+                decode_batch->connection_state = connection_state;
+                decode_batch->compression_threshold = compression_threshold;
+                decode_batch->data.reserve(consumed - span.offset);
             }
-            else
+            FrameSpan batch_span = span;
+            batch_span.offset = decode_batch->data.size();
+            decode_batch->spans.push_back(batch_span);
+            decode_batch->data.insert(std::end(decode_batch->data), packet_start, packet_start + frame_size);
+
+            decoded = false;
+            if (latency_stats_ != nullptr)
             {
-                output_packet = replacement_data;
+                packet_id = PeekPacketId(src_data.data() + span.offset + span.header_length, span.length, compression_threshold);
             }
+        }
+        else
+        {
+            const ProtocolCraft::ConnectionState previous_state = connection_state;
+            packet_id = decoder->Decode(from, connection_state, compression_threshold, read_iter, parse_max_size, frame_size, this);
 
-            output_data_mutex.lock();
-            const bool write_in_progress = !output_dst_data.empty();
-            output_dst_data.push_back(output_packet);
-
-            if (!write_in_progress)
+            // The server is chosen by the Handshake, anything else can't be sent anywhere
+            if (host_router_ != nullptr && from == Origin::Client &&
+                previous_state == ProtocolCraft::ConnectionState::Handshake && connection_state == ProtocolCraft::ConnectionState::Handshake)
             {
-                output_buffer_ = output_dst_data.front();
-                if ((from == Origin::Server))
-                {
-                    asio::async_write(client_socket_, asio::buffer(output_buffer_.data(), output_buffer_.size()),
-                        std::bind(&MinecraftProxy::handle_client_write, this,
-                            std::placeholders::_1));
-                }
-                else
-                {
-                    asio::async_write(server_socket_, asio::buffer(output_buffer_.data(), output_buffer_.size()),
-                        std::bind(&MinecraftProxy::handle_server_write, this,
-                            std::placeholders::_1));
-                }
+                std::cerr << "First packet from the client is not a valid handshake, closing the session" << std::endl;
+                return false;
             }
-            output_data_mutex.unlock();
+        }
+
+        if (latency_stats_ != nullptr)
+        {
+            // Forwarded right after framing if decoded later on the pool
+            timing.parsed = decoded ? std::chrono::steady_clock::now() : timing.framed;
+            timing.id = packet_id;
+            timing.decoded = decoded;
+        }
 
-            src_data.erase(std::begin(src_data), std::begin(src_data) + bytes_read + packet_length);
+        output_data_mutex.lock();
+        if (replacement_data.size() == 0)
+        {
+            output_dst_data.insert(std::end(output_dst_data), packet_start, packet_start + frame_size);
         }
         else
         {
-            break;
+            output_dst_data.insert(std::end(output_dst_data), std::begin(replacement_data), std::end(replacement_data));
         }
+        output_dst_packets += 1;
+        if (latency_stats_ != nullptr)
+        {
+            output_dst_timings.push_back(timing);
+        }
+        output_data_mutex.unlock();
     }
-}
 
-void MinecraftProxy::ParsePacket(const Origin from, std::vector<unsigned char>::const_iterator& read_iter, size_t& max_length)
-{
-    int minecraftID = -1;
-    std::vector<unsigned char> uncompressed;
+    if (decode_batch != nullptr)
+    {
+        decoder->DecodeAsync(decode_batch);
+    }
 
-    if (compression_threshold >= 0)
+    if (consumed > 0)
     {
-        int data_length = ProtocolCraft::ReadVarInt(read_iter, max_length);
+        {
+            SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::Framing);
+            src_data.erase(std::begin(src_data), std::begin(src_data) + consumed);
+        }
+
+        // Everything extracted from this read is sent in one write
+        output_data_mutex.lock();
+        StartWrite(from == Origin::Server ? Origin::Client : Origin::Server);
+        output_data_mutex.unlock();
+    }
 
-        if (data_length != 0)
+    if (from == Origin::Client && !server_connected_)
+    {
+        output_server_mutex_.lock();
+        const size_t waiting_data = output_server_data_.size() + src_data.size();
+        output_server_mutex_.unlock();
+        if (waiting_data > MAX_PRECONNECT_DATA)
         {
-            uncompressed = Decompress(std::vector<unsigned char>(read_iter, read_iter + max_length), 0);
-            read_iter = std::begin(uncompressed);
-            max_length = uncompressed.size();
+            std::cerr << "Client sent " << waiting_data << " bytes before the server connection, closing the session" << std::endl;
+            return false;
         }
     }
 
-    minecraftID = ProtocolCraft::ReadVarInt(read_iter, max_length);
+    return true;
+}
+
+void MinecraftProxy::StartWrite(const Origin dst)
+{
+    std::vector<unsigned char>& output_data = (dst == Origin::Client) ? output_client_data_ : output_server_data_;
+    std::vector<unsigned char>& output_buffer = (dst == Origin::Client) ? output_client_buffer_ : output_server_buffer_;
+    size_t& output_data_packets = (dst == Origin::Client) ? output_client_data_packets_ : output_server_data_packets_;
+    size_t& output_buffer_packets = (dst == Origin::Client) ? output_client_buffer_packets_ : output_server_buffer_packets_;
+
+    // A write is already in progress or nothing to write
+    if (!output_buffer.empty() || output_data.empty())
+    {
+        return;
+    }
+
+    // Kept until the connection is established
+    if (dst == Origin::Server && !server_connected_)
+    {
+        return;
+    }
+
+    output_buffer.swap(output_data);
+    std::swap(output_buffer_packets, output_data_packets);
 
-    std::shared_ptr<ProtocolCraft::Message> msg;
+    if (dst == Origin::Client)
+    {
+        pending_operations_ += 1;
+        asio::async_write(client_socket_, asio::buffer(output_buffer.data(), output_buffer.size()),
+            std::bind(&MinecraftProxy::handle_client_write, this,
+                std::placeholders::_1));
+    }
+    else
+    {
+        pending_operations_ += 1;
+        asio::async_write(server_socket_, asio::buffer(output_buffer.data(), output_buffer.size()),
+            std::bind(&MinecraftProxy::handle_server_write, this,
+                std::placeholders::_1));
+    }
+}
 
-    if (from == Origin::Client)
+#ifdef __linux__
+const bool MinecraftProxy::CanSplice() const
+{
+    // Per packet instrumentation needs the packets
+    if (latency_stats_ != nullptr || decoder->GetLogger().IsStatsMode())
     {
-        msg = ProtocolCraft::MessageFactory::CreateMessageServerbound(minecraftID, connection_state);
+        return false;
     }
-    else if (from == Origin::Server)
+
+    std::shared_ptr<const Configuration> conf = config_watcher_.GetConfiguration();
+    return conf->IsAllIgnored(ProtocolCraft::ConnectionState::Play, Origin::Server) &&
+        conf->IsAllIgnored(ProtocolCraft::ConnectionState::Play, Origin::Client);
+}
+
+const bool MinecraftProxy::StartSplice(const Origin from)
+{
+    SpliceLeg& leg = splice_legs_[static_cast<int>(from)];
+    if (pipe2(leg.pipe_fds, O_NONBLOCK | O_CLOEXEC) != 0)
     {
-        msg = ProtocolCraft::MessageFactory::CreateMessageClientbound(minecraftID, connection_state);
+        std::cerr << "Can't create splice pipe, falling back to normal forwarding" << std::endl;
+        leg.pipe_fds[0] = -1;
+        leg.pipe_fds[1] = -1;
+        splice_enabled_ = false;
+        return false;
     }
 
-    if (msg != nullptr)
+    asio::ip::tcp::socket& src_socket = (from == Origin::Server) ? server_socket_ : client_socket_;
+    asio::ip::tcp::socket& dst_socket = (from == Origin::Server) ? client_socket_ : server_socket_;
+    asio::error_code ec;
+    src_socket.native_non_blocking(true, ec);
+    dst_socket.native_non_blocking(true, ec);
+
+    std::vector<unsigned char>& src_data = (from == Origin::Server) ? input_server_data : input_client_data_;
+    std::vector<unsigned char>& output_dst_data = (from == Origin::Server) ? output_client_data_ : output_server_data_;
+    std::vector<unsigned char>& output_dst_buffer = (from == Origin::Server) ? output_client_buffer_ : output_server_buffer_;
+    std::mutex& output_data_mutex = (from == Origin::Server) ? output_client_mutex_ : output_server_mutex_;
+
+    bool flushed = false;
+    output_data_mutex.lock();
+    // Start of an incomplete packet, forwarded as is
+    output_dst_data.insert(std::end(output_dst_data), std::begin(src_data), std::end(src_data));
+    src_data.clear();
+    StartWrite(from == Origin::Server ? Origin::Client : Origin::Server);
+    flushed = output_dst_buffer.empty();
+    leg.pending = !flushed;
+    output_data_mutex.unlock();
+
+    if (from == Origin::Server)
     {
-        try
+        std::cout << "Session " << session_id << " switched to kernel passthrough" << std::endl;
+    }
+
+    // Otherwise started by the write handler
+    if (flushed)
+    {
+        SpliceStep(from);
+    }
+
+    return true;
+}
+
+void MinecraftProxy::SpliceStep(const Origin from)
+{
+    asio::ip::tcp::socket& src_socket = (from == Origin::Server) ? server_socket_ : client_socket_;
+    asio::ip::tcp::socket& dst_socket = (from == Origin::Server) ? client_socket_ : server_socket_;
+    SpliceLeg& leg = splice_legs_[static_cast<int>(from)];
+
+    size_t budget = SPLICE_STEP_BUDGET;
+    while (true)
+    {
+        // Drain the pipe first
+        if (leg.in_pipe > 0)
         {
-            msg->Read(read_iter, max_length);
-            msg->Dispatch(this);
+            const ssize_t written = splice(leg.pipe_fds[0], nullptr, dst_socket.native_handle(), nullptr,
+                leg.in_pipe, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (written > 0)
+            {
+                leg.in_pipe -= written;
+                continue;
+            }
+            if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                pending_operations_ += 1;
+                dst_socket.async_wait(asio::socket_base::wait_write,
+                    std::bind(&MinecraftProxy::handle_splice_wait, this, from, std::placeholders::_1));
+                return;
+            }
+            Close();
+            return;
         }
-        catch (const std::exception & ex)
+
+        if (budget == 0)
         {
-            std::cout << ((from == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
-                "PARSING EXCEPTION: " << ex.what() << " || " << msg->GetName() << std::endl;
+            break;
         }
+
+        const ssize_t read = splice(src_socket.native_handle(), nullptr, leg.pipe_fds[1], nullptr,
+            SPLICE_CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (read > 0)
+        {
+            leg.in_pipe += read;
+            Metrics::Add(from == Origin::Server ? MetricCounter::BytesFromServer : MetricCounter::BytesFromClient, read);
+            if (timer_wheel_ != nullptr)
+            {
+                last_activity_ = timer_wheel_->CurrentTick();
+            }
+            budget = budget > static_cast<size_t>(read) ? budget - read : 0;
+            continue;
+        }
+        if (read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        // 0 is the end of the stream
+        Close();
+        return;
+    }
+
+    pending_operations_ += 1;
+    src_socket.async_wait(asio::socket_base::wait_read,
+        std::bind(&MinecraftProxy::handle_splice_wait, this, from, std::placeholders::_1));
+}
+
+void MinecraftProxy::handle_splice_wait(const Origin from, const asio::error_code& ec)
+{
+    if (FinishOperation())
+    {
+        return;
+    }
+
+    if (!ec)
+    {
+        SpliceStep(from);
     }
     else
     {
-        std::cout << ((from == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
-            "NULL MESSAGE WITH ID: " << minecraftID << std::endl;
+        Close();
     }
+}
+#endif
 
-    logger.Log(msg, connection_state, from);
+void MinecraftProxy::ScheduleTimeout()
+{
+    unsigned long long deadline = phase_deadline_;
+    if (idle_timeout_ticks_ > 0 && (deadline == 0 || last_activity_ + idle_timeout_ticks_ < deadline))
+    {
+        deadline = last_activity_ + idle_timeout_ticks_;
+    }
+
+    if (deadline == 0)
+    {
+        timer_wheel_->Cancel(timeout_entry_);
+        return;
+    }
+    timer_wheel_->Schedule(timeout_entry_, deadline);
 }
 
-const std::vector<unsigned char> MinecraftProxy::PacketToBytes(const ProtocolCraft::Message& msg)
+void MinecraftProxy::handle_timeout()
 {
-    std::vector<unsigned char> content;
-    msg.Write(content);
+    const unsigned long long now = timer_wheel_->CurrentTick();
+    if (phase_deadline_ != 0 && now >= phase_deadline_)
+    {
+        std::cout << (connection_state == ProtocolCraft::ConnectionState::Handshake ? "Handshake" :
+            connection_state == ProtocolCraft::ConnectionState::Status ? "Status" : "Login") << " timeout" << std::endl;
+        Close();
+        return;
+    }
+    if (idle_timeout_ticks_ > 0 && now >= last_activity_ + idle_timeout_ticks_)
+    {
+        std::cout << "Idle timeout" << std::endl;
+        Close();
+        return;
+    }
 
+    // Data was received since the entry was scheduled
+    ScheduleTimeout();
+}
+
+void MinecraftProxy::RecordWrittenPacket(const Origin dst)
+{
+    if (latency_stats_ == nullptr)
+    {
+        return;
+    }
+
+    std::deque<PacketTiming>& timings = (dst == Origin::Client) ? output_client_timings_ : output_server_timings_;
+    if (timings.empty())
+    {
+        return;
+    }
+
+    // Packets written to the client come from the server
+    const Origin from = (dst == Origin::Client) ? Origin::Server : Origin::Client;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    latency_stats_->Record(from, timings.front(), now);
+    latency_stats_delta_->Record(from, timings.front(), now);
+    timings.pop_front();
+
+    if (now - last_latency_dump_ >= latency_dump_interval_)
+    {
+        last_latency_dump_ = now;
+        DumpLatencyStats();
+    }
+}
+
+void MinecraftProxy::DumpLatencyStats()
+{
+    if (!latency_stats_->IsEmpty())
+    {
+        decoder->GetLogger().LogMessage("Session latency stats\n" + latency_stats_->ToString(latency_top_packets_));
+    }
+
+    LatencyStats::MergeIntoGlobal(*latency_stats_delta_);
+    latency_stats_delta_->Reset();
+}
+
+void MinecraftProxy::PacketToBytes(const ProtocolCraft::Message& msg, std::vector<unsigned char>& output)
+{
+    SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::PacketToBytes);
+    // Room for the length and data length varints, written
+    // backward in front of the content once its size is known
+    const size_t headroom = 2 * MAX_VARINT_LENGTH;
+    packet_write_buffer_.resize(headroom);
+    msg.Write(packet_write_buffer_);
+    const int content_size = static_cast<int>(packet_write_buffer_.size() - headroom);
+
+    std::vector<unsigned char>* packet = &packet_write_buffer_;
+    size_t start = headroom;
     if (compression_threshold != -1)
     {
-        if (content.size() < compression_threshold)
+        if (content_size < compression_threshold)
         {
-            content.insert(content.begin(), 0x00);
-
+            // Data length of 0, not compressed
+            start -= 1;
+            packet_write_buffer_[start] = 0x00;
         }
         else
         {
-            std::vector<unsigned char> compressed_data = Compress(content);
-            content.clear();
-            ProtocolCraft::WriteVarInt(content.size(), content);
-            content.insert(content.end(), compressed_data.begin(), compressed_data.end());
+            if (compressor_ == nullptr)
+            {
+                compressor_ = std::unique_ptr<Compressor>(new Compressor());
+            }
+            packet_compress_buffer_.resize(headroom);
+            compressor_->Compress(packet_write_buffer_.data() + headroom, content_size, packet_compress_buffer_);
+            packet = &packet_compress_buffer_;
+            // Data length is the uncompressed size
+            start -= VarIntSize(content_size);
+            EncodeVarInt(content_size, packet->data() + start);
         }
     }
 
-    std::vector<unsigned char> sized_packet;
-    ProtocolCraft::WriteVarInt(content.size(), sized_packet);
-    sized_packet.insert(sized_packet.end(), content.begin(), content.end());
-    return sized_packet;
+    const int length = static_cast<int>(packet->size() - start);
+    start -= VarIntSize(length);
+    EncodeVarInt(length, packet->data() + start);
+    output.insert(output.end(), packet->begin() + start, packet->end());
 }
 
 void MinecraftProxy::Handle(ProtocolCraft::Message& msg)
@@ -332,19 +906,45 @@ void MinecraftProxy::Handle(ProtocolCraft::Handshake& msg)
 {
     connection_state = (ProtocolCraft::ConnectionState)msg.GetNextState();
 
+    if (timer_wheel_ != nullptr)
+    {
+        // A status request is as short as a handshake, only a login gets the longer deadline
+        const unsigned long long phase_ticks = connection_state == ProtocolCraft::ConnectionState::Status ?
+            handshake_timeout_ticks_ : login_timeout_ticks_;
+        phase_deadline_ = phase_ticks > 0 ? timer_wheel_->CurrentTick() + phase_ticks : 0;
+        ScheduleTimeout();
+    }
+
+    if (host_router_ != nullptr && !server_connected_)
+    {
+        const Upstream* upstream = host_router_->Find(msg.GetServerAddress());
+        if (upstream != nullptr)
+        {
+            server_ip_ = upstream->ip;
+            server_port_ = upstream->port;
+        }
+        std::cout << "Routing " << HostRouter::NormalizeHostname(msg.GetServerAddress()) << " to "
+            << server_ip_ << ":" << server_port_ << (upstream == nullptr ? " (default)" : "") << std::endl;
+        ConnectToServer();
+    }
+
     ProtocolCraft::Handshake replacement_handshake;
     replacement_handshake.SetNextState(msg.GetNextState());
     replacement_handshake.SetProtocolVersion(msg.GetProtocolVersion());
     replacement_handshake.SetServerAddress(server_ip_);
     replacement_handshake.SetServerPort(server_port_);
 
-    const std::vector<unsigned char> replacement_bytes = PacketToBytes(replacement_handshake);
-    client_replacement_data.insert(client_replacement_data.end(), replacement_bytes.begin(), replacement_bytes.end());
+    PacketToBytes(replacement_handshake, client_replacement_data);
 }
 
 void MinecraftProxy::Handle(ProtocolCraft::LoginSuccess& msg)
 {
     connection_state = ProtocolCraft::ConnectionState::Play;
+    // Only the idle timeout is left, the entry is moved when it fires
+    phase_deadline_ = 0;
+#ifdef __linux__
+    splice_enabled_ = CanSplice();
+#endif
 }
 
 void MinecraftProxy::Handle(ProtocolCraft::SetCompression& msg)
@@ -0,0 +1,294 @@
+#include "sniffcraft/PacketDecoder.hpp"
+#include "sniffcraft/Compression.hpp"
+#include "sniffcraft/ConfigWatcher.hpp"
+#include "sniffcraft/FrameScanner.hpp"
+#include "sniffcraft/Metrics.hpp"
+#include "sniffcraft/Profiler.hpp"
+
+#include <protocolCraft/BinaryReadWrite.hpp>
+#include <protocolCraft/MessageFactory.hpp>
+
+#include <array>
+#include <iostream>
+#include <string>
+
+// Protocol limit for the size of an uncompressed packet
+const int MAX_UNCOMPRESSED_PACKET_LENGTH = 2097152;
+
+// Per session, batches above this are dropped instead of growing the pool backlog without limit
+const size_t MAX_QUEUED_DECODE_BYTES = 16 * 1024 * 1024;
+
+// Enough for all the packet ids of the supported versions
+const int MAX_POOLED_PACKET_ID = 256;
+// Handshake, Status, Login and Play
+const int NUM_POOLED_STATES = 4;
+// Free messages kept for one origin/state/id, the others are freed
+const size_t MAX_POOLED_MESSAGES = 32;
+
+PacketDecoder::PacketDecoder(const ConfigWatcher& config_watcher, const unsigned long long session_id, asio::thread_pool* decode_pool,
+    LoggerService& logger_service) :
+    logger(Logger::Create(logger_service, config_watcher, session_id)),
+    config_watcher(config_watcher),
+    queued_decode_bytes(0),
+    dropped_decode_packets(0)
+{
+    if (decode_pool != nullptr)
+    {
+        decode_strand = std::unique_ptr<asio::strand<asio::thread_pool::executor_type> >(
+            new asio::strand<asio::thread_pool::executor_type>(decode_pool->get_executor()));
+    }
+
+    configuration_version = config_watcher.GetVersion();
+    configuration = config_watcher.GetConfiguration();
+
+    message_pool.resize(2 * NUM_POOLED_STATES * MAX_POOLED_PACKET_ID);
+}
+
+PacketDecoder::~PacketDecoder()
+{
+    logger->Stop();
+}
+
+Logger& PacketDecoder::GetLogger()
+{
+    return *logger;
+}
+
+const bool PacketDecoder::HasDecodePool() const
+{
+    return decode_strand != nullptr;
+}
+
+const int PacketDecoder::Decode(const Origin from, const ProtocolCraft::ConnectionState& connection_state, const int compression_threshold,
+    std::vector<unsigned char>::const_iterator& read_iter, size_t& max_length, const size_t wire_size,
+    ProtocolCraft::Handler* handler)
+{
+    int minecraftID = -1;
+
+    // In stats mode, Play packets are only counted, as they can't change the proxy state
+    const bool stats_only = logger->IsStatsMode() && connection_state == ProtocolCraft::ConnectionState::Play;
+
+    if (compression_threshold >= 0)
+    {
+        int data_length = ProtocolCraft::ReadVarInt(read_iter, max_length);
+
+        if (data_length != 0 && stats_only)
+        {
+            // We only need the id, which is at most 5 bytes
+            std::array<unsigned char, MAX_VARINT_LENGTH> id_bytes;
+            SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::Decompression);
+            const size_t id_length = DecompressPrefix(&(*read_iter), max_length, id_bytes.data(), id_bytes.size());
+            if (DecodeVarInt(id_bytes.data(), id_length, minecraftID) <= 0)
+            {
+                Metrics::Add(MetricCounter::ParseExceptions);
+                return -1;
+            }
+
+            Metrics::AddPacket(from, connection_state, minecraftID);
+            logger->LogPacketStats(from, connection_state, minecraftID, wire_size, data_length);
+            return minecraftID;
+        }
+
+        if (data_length != 0)
+        {
+            SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::Decompression);
+            std::vector<unsigned char>& decompressed = (from == Origin::Server) ? server_decompressed_data : client_decompressed_data;
+
+            // Don't allocate anything for invalid sizes, the packet is forwarded as is
+            if (data_length < 0 || data_length > MAX_UNCOMPRESSED_PACKET_LENGTH)
+            {
+                Metrics::Add(MetricCounter::ParseExceptions);
+                std::cout << ((from == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
+                    "INVALID UNCOMPRESSED SIZE: " << data_length << std::endl;
+                return -1;
+            }
+
+            // Positive from here
+            const size_t decompressed_size = static_cast<size_t>(data_length);
+
+            const std::chrono::steady_clock::time_point decompress_start = std::chrono::steady_clock::now();
+            if (decompressed.size() < decompressed_size)
+            {
+                decompressed.resize(decompressed_size);
+            }
+            try
+            {
+                Decompress(&(*read_iter), max_length, decompressed.data(), decompressed_size);
+            }
+            catch (const std::exception& ex)
+            {
+                Metrics::Add(MetricCounter::ParseExceptions);
+                std::cout << ((from == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
+                    "DECOMPRESSION EXCEPTION: " << ex.what() << std::endl;
+                return -1;
+            }
+            Metrics::Add(MetricCounter::DecompressCalls);
+            Metrics::Add(MetricCounter::DecompressNanoseconds,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - decompress_start).count());
+            read_iter = std::begin(decompressed);
+            max_length = decompressed_size;
+        }
+    }
+
+    const size_t uncompressed_size = max_length;
+    minecraftID = ProtocolCraft::ReadVarInt(read_iter, max_length);
+    Metrics::AddPacket(from, connection_state, minecraftID);
+
+    if (logger->IsStatsMode())
+    {
+        logger->LogPacketStats(from, connection_state, minecraftID, wire_size, uncompressed_size);
+        if (stats_only)
+        {
+            return minecraftID;
+        }
+    }
+
+    // Like in stats mode, ignored Play packets can't change the proxy
+    // state, so there is no need to read them if they are not logged
+    UpdateConfiguration();
+    if (connection_state == ProtocolCraft::ConnectionState::Play &&
+        configuration->IsIgnored(connection_state, from, minecraftID))
+    {
+        return minecraftID;
+    }
+
+    std::shared_ptr<ProtocolCraft::Message> msg;
+
+    {
+        SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::MessageCreation);
+        msg = GetPooledMessage(from, connection_state, minecraftID);
+    }
+
+    if (msg != nullptr)
+    {
+        try
+        {
+            {
+                SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::MessageRead);
+                msg->Read(read_iter, max_length);
+            }
+            if (handler != nullptr)
+            {
+                SNIFFCRAFT_PROFILE_SCOPE(ProfileStage::MessageDispatch);
+                msg->Dispatch(handler);
+            }
+        }
+        catch (const std::exception & ex)
+        {
+            Metrics::Add(MetricCounter::ParseExceptions);
+            std::cout << ((from == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
+                "PARSING EXCEPTION: " << ex.what() << " || " << msg->GetName() << std::endl;
+        }
+    }
+    else
+    {
+        std::cout << ((from == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
+            "NULL MESSAGE WITH ID: " << minecraftID << std::endl;
+    }
+
+    if (!logger->IsStatsMode())
+    {
+        logger->Log(std::move(msg), connection_state, from);
+    }
+
+    return minecraftID;
+}
+
+void PacketDecoder::DecodeAsync(const std::shared_ptr<DecodeBatch>& batch)
+{
+    const size_t batch_size = batch->data.size();
+    if (queued_decode_bytes.fetch_add(batch_size) + batch_size > MAX_QUEUED_DECODE_BYTES)
+    {
+        queued_decode_bytes.fetch_sub(batch_size);
+        dropped_decode_packets.fetch_add(batch->spans.size());
+        Metrics::Add(MetricCounter::DecodePacketsDropped, batch->spans.size());
+        return;
+    }
+
+    std::shared_ptr<PacketDecoder> self = shared_from_this();
+    asio::post(*decode_strand, [self, batch, batch_size]()
+        {
+            const unsigned long long dropped = self->dropped_decode_packets.exchange(0);
+            if (dropped > 0)
+            {
+                self->logger->LogMessage("Decode queue full: " + std::to_string(dropped) + " packets forwarded without being decoded");
+            }
+            self->DecodeBatchNow(*batch);
+            self->queued_decode_bytes.fetch_sub(batch_size);
+        });
+}
+
+void PacketDecoder::DecodeBatchNow(DecodeBatch& batch)
+{
+    for (size_t i = 0; i < batch.spans.size(); ++i)
+    {
+        const FrameSpan& span = batch.spans[i];
+        std::vector<unsigned char>::const_iterator read_iter = batch.data.cbegin() + span.offset + span.header_length;
+        size_t max_length = span.length;
+        try
+        {
+            Decode(batch.origin, batch.connection_state, batch.compression_threshold,
+                read_iter, max_length, span.header_length + span.length, nullptr);
+        }
+        catch (const std::exception& ex)
+        {
+            // Nothing in the pool should stop because of one bad packet
+            Metrics::Add(MetricCounter::ParseExceptions);
+            std::cout << ((batch.origin == Origin::Server) ? "Server --> Client: " : "Client --> Server: ") <<
+                "DECODING EXCEPTION: " << ex.what() << std::endl;
+        }
+    }
+}
+
+void PacketDecoder::UpdateConfiguration()
+{
+    const unsigned int latest_version = config_watcher.GetVersion();
+    if (latest_version != configuration_version)
+    {
+        configuration_version = latest_version;
+        configuration = config_watcher.GetConfiguration();
+    }
+}
+
+std::shared_ptr<ProtocolCraft::Message> PacketDecoder::GetPooledMessage(const Origin from, const ProtocolCraft::ConnectionState connection_state, const int id)
+{
+    // Messages written by the logger since the last call
+    if (logger->HasReleasedMessages())
+    {
+        logger->TakeReleasedMessages(released_messages);
+        for (size_t i = 0; i < released_messages.size(); ++i)
+        {
+            const ReleasedMessage& released = released_messages[i];
+            const int released_id = released.msg->GetId();
+            const int released_state = static_cast<int>(released.connection_state);
+            if (released_id < 0 || released_id >= MAX_POOLED_PACKET_ID || released_state < 0 || released_state >= NUM_POOLED_STATES)
+            {
+                continue;
+            }
+            std::vector<std::shared_ptr<ProtocolCraft::Message> >& free_messages =
+                message_pool[(static_cast<int>(released.origin) * NUM_POOLED_STATES + released_state) * MAX_POOLED_PACKET_ID + released_id];
+            if (free_messages.size() < MAX_POOLED_MESSAGES)
+            {
+                free_messages.push_back(released.msg);
+            }
+        }
+        released_messages.clear();
+    }
+
+    const int state = static_cast<int>(connection_state);
+    if (id >= 0 && id < MAX_POOLED_PACKET_ID && state >= 0 && state < NUM_POOLED_STATES)
+    {
+        std::vector<std::shared_ptr<ProtocolCraft::Message> >& free_messages =
+            message_pool[(static_cast<int>(from) * NUM_POOLED_STATES + state) * MAX_POOLED_PACKET_ID + id];
+        if (!free_messages.empty())
+        {
+            std::shared_ptr<ProtocolCraft::Message> msg = std::move(free_messages.back());
+            free_messages.pop_back();
+            return msg;
+        }
+    }
+
+    return from == Origin::Client ?
+        ProtocolCraft::MessageFactory::CreateMessageServerbound(id, connection_state) :
+        ProtocolCraft::MessageFactory::CreateMessageClientbound(id, connection_state);
+}
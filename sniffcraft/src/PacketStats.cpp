@@ -0,0 +1,120 @@
+#include "sniffcraft/PacketStats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include <protocolCraft/MessageFactory.hpp>
+
+const int PacketStats::MAX_ID;
+const int PacketStats::NUM_STATE;
+const int PacketStats::NUM_ENTRIES;
+const int PacketStats::NUM_SIZE_BUCKETS;
+
+PacketStats::PacketStats() :
+    counts(NUM_ENTRIES, 0),
+    wire_bytes(NUM_ENTRIES, 0),
+    uncompressed_bytes(NUM_ENTRIES, 0),
+    size_histograms(NUM_ENTRIES * NUM_SIZE_BUCKETS, 0)
+{
+    total_count = 0;
+}
+
+void PacketStats::Record(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id,
+    const size_t wire_size, const size_t uncompressed_size)
+{
+    const int index = Index(origin, connection_state, id);
+    if (index < 0)
+    {
+        return;
+    }
+
+    counts[index] += 1;
+    wire_bytes[index] += wire_size;
+    uncompressed_bytes[index] += uncompressed_size;
+    size_histograms[index * NUM_SIZE_BUCKETS + SizeBucket(wire_size)] += 1;
+    total_count += 1;
+}
+
+const bool PacketStats::IsEmpty() const
+{
+    return total_count == 0;
+}
+
+const int PacketStats::Index(const Origin origin, const ProtocolCraft::ConnectionState connection_state, const int id)
+{
+    const int state = static_cast<int>(connection_state);
+    if (state < 0 || state >= NUM_STATE || id < 0 || id >= MAX_ID)
+    {
+        return -1;
+    }
+    return (static_cast<int>(origin) * NUM_STATE + state) * MAX_ID + id;
+}
+
+const int PacketStats::SizeBucket(const size_t size)
+{
+    int bucket = -3;
+    for (size_t s = size; s > 1; s >>= 1)
+    {
+        bucket += 1;
+    }
+    return std::min(std::max(bucket, 0), NUM_SIZE_BUCKETS - 1);
+}
+
+const std::string PacketStats::ToString(const size_t top_n) const
+{
+    const char* state_names[NUM_STATE] = { "Handshaking", "Status", "Login", "Play" };
+
+    std::vector<int> indices;
+    unsigned long long total_wire_bytes = 0;
+    unsigned long long total_uncompressed_bytes = 0;
+    for (int i = 0; i < NUM_ENTRIES; ++i)
+    {
+        if (counts[i] > 0)
+        {
+            indices.push_back(i);
+            total_wire_bytes += wire_bytes[i];
+            total_uncompressed_bytes += uncompressed_bytes[i];
+        }
+    }
+
+    std::sort(indices.begin(), indices.end(), [this](const int a, const int b) { return wire_bytes[a] > wire_bytes[b]; });
+
+    std::stringstream output;
+    output << "Packet stats: " << total_count << " packets, "
+        << total_wire_bytes << " bytes on the wire, "
+        << total_uncompressed_bytes << " bytes uncompressed\n";
+    output << std::left << std::setw(10) << "dir" << std::setw(12) << "state" << std::setw(45) << "packet" << std::right
+        << std::setw(10) << "count" << std::setw(14) << "wire bytes" << std::setw(8) << "wire %"
+        << std::setw(14) << "raw bytes" << std::setw(10) << "avg size" << std::setw(12) << "size mode" << "\n";
+
+    for (size_t i = 0; i < indices.size() && i < top_n; ++i)
+    {
+        const int index = indices[i];
+        const bool is_server = index / (NUM_STATE * MAX_ID) == static_cast<int>(Origin::Server);
+        const int state = (index / MAX_ID) % NUM_STATE;
+        const int id = index % MAX_ID;
+
+        auto msg = is_server ?
+            ProtocolCraft::MessageFactory::CreateMessageClientbound(id, static_cast<ProtocolCraft::ConnectionState>(state)) :
+            ProtocolCraft::MessageFactory::CreateMessageServerbound(id, static_cast<ProtocolCraft::ConnectionState>(state));
+
+        // Most frequent wire size range
+        const unsigned int* histogram = size_histograms.data() + index * NUM_SIZE_BUCKETS;
+        const int mode = static_cast<int>(std::max_element(histogram, histogram + NUM_SIZE_BUCKETS) - histogram);
+        std::string mode_str = mode == 0 ? "<16" :
+            (mode == NUM_SIZE_BUCKETS - 1 ? ">=" + std::to_string(1ULL << (mode + 3)) : std::to_string(1ULL << (mode + 3)) + "-" + std::to_string((1ULL << (mode + 4)) - 1));
+
+        output << std::left << std::setw(10) << (is_server ? "S --> C" : "C --> S")
+            << std::setw(12) << state_names[state]
+            << std::setw(45) << (msg == nullptr ? "Unknown (" + std::to_string(id) + ")" : msg->GetName()) << std::right
+            << std::setw(10) << counts[index]
+            << std::setw(14) << wire_bytes[index]
+            << std::setw(8) << std::fixed << std::setprecision(1) << (total_wire_bytes > 0 ? 100.0 * wire_bytes[index] / total_wire_bytes : 0.0)
+            << std::setw(14) << uncompressed_bytes[index]
+            << std::setw(10) << wire_bytes[index] / counts[index]
+            << std::setw(12) << mode_str << "\n";
+    }
+
+    return output.str();
+}
@@ -0,0 +1,76 @@
+#include "sniffcraft/Profiler.hpp"
+#include "sniffcraft/ThreadShards.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+const int NUM_PROFILE_STAGE = static_cast<int>(ProfileStage::NUM_PROFILE_STAGE);
+
+struct ProfilerSlot
+{
+    ProfilerSlot()
+    {
+        for (int i = 0; i < NUM_PROFILE_STAGE; ++i)
+        {
+            calls[i].store(0, std::memory_order_relaxed);
+            nanoseconds[i].store(0, std::memory_order_relaxed);
+            max_nanoseconds[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<unsigned long long> calls[NUM_PROFILE_STAGE];
+    std::atomic<unsigned long long> nanoseconds[NUM_PROFILE_STAGE];
+    std::atomic<unsigned long long> max_nanoseconds[NUM_PROFILE_STAGE];
+};
+
+void Profiler::Add(const ProfileStage stage, const unsigned long long nanoseconds)
+{
+    ProfilerSlot& slot = ThreadShards<ProfilerSlot>::Local();
+    const int index = static_cast<int>(stage);
+
+    // Only the owner thread writes in a slot
+    slot.calls[index].store(slot.calls[index].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    slot.nanoseconds[index].store(slot.nanoseconds[index].load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds > slot.max_nanoseconds[index].load(std::memory_order_relaxed))
+    {
+        slot.max_nanoseconds[index].store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+const std::string Profiler::Summary()
+{
+    std::vector<unsigned long long> calls(NUM_PROFILE_STAGE, 0);
+    std::vector<unsigned long long> nanoseconds(NUM_PROFILE_STAGE, 0);
+    std::vector<unsigned long long> max_nanoseconds(NUM_PROFILE_STAGE, 0);
+    const size_t num_threads = ThreadShards<ProfilerSlot>::ForEach([&](const ProfilerSlot& slot)
+        {
+            for (int i = 0; i < NUM_PROFILE_STAGE; ++i)
+            {
+                calls[i] += slot.calls[i].load(std::memory_order_relaxed);
+                nanoseconds[i] += slot.nanoseconds[i].load(std::memory_order_relaxed);
+                max_nanoseconds[i] = std::max(max_nanoseconds[i], slot.max_nanoseconds[i].load(std::memory_order_relaxed));
+            }
+        });
+
+    const char* stage_names[NUM_PROFILE_STAGE] = { "framing", "decompression", "message creation", "read", "dispatch", "packet to bytes", "log formatting" };
+
+    std::stringstream output;
+    output << "Profiler summary (" << num_threads << " thread" << (num_threads > 1 ? "s" : "") << ")\n";
+    output << std::left << std::setw(18) << "stage" << std::right
+        << std::setw(14) << "calls" << std::setw(14) << "total (ms)"
+        << std::setw(12) << "mean (us)" << std::setw(12) << "max (us)" << "\n";
+    output << std::fixed << std::setprecision(2);
+    for (int i = 0; i < NUM_PROFILE_STAGE; ++i)
+    {
+        output << std::left << std::setw(18) << stage_names[i] << std::right
+            << std::setw(14) << calls[i]
+            << std::setw(14) << nanoseconds[i] / 1e6
+            << std::setw(12) << (calls[i] == 0 ? 0.0 : nanoseconds[i] / 1e3 / calls[i])
+            << std::setw(12) << max_nanoseconds[i] / 1e3 << "\n";
+    }
+
+    return output.str();
+}
@@ -0,0 +1,135 @@
+#include "sniffcraft/RotatingLogFile.hpp"
+#include "sniffcraft/BackgroundCompressor.hpp"
+#include "sniffcraft/FileUtilities.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+RotatingLogFile::RotatingLogFile()
+{
+    rotation_enabled = false;
+    max_segment_size = 0;
+    max_segment_duration = std::chrono::seconds(0);
+    compress = false;
+    max_segments = 0;
+    segment_index = 0;
+    segment_size = 0;
+}
+
+RotatingLogFile::~RotatingLogFile()
+{
+    Close();
+}
+
+void RotatingLogFile::Open(const std::string& name_prefix, const std::string& extension_, const Configuration& conf)
+{
+    Close();
+
+    base_path = name_prefix;
+    if (!conf.log_directory.empty())
+    {
+        if (!CreateDirectories(conf.log_directory))
+        {
+            std::cerr << "Error trying to create log directory " << conf.log_directory << ", using working directory instead" << std::endl;
+        }
+        else
+        {
+            const char last = conf.log_directory.back();
+            base_path = conf.log_directory + ((last == '/' || last == '\\') ? "" : "/") + name_prefix;
+        }
+    }
+    extension = extension_;
+
+    max_segment_size = conf.log_rotation_size;
+    max_segment_duration = conf.log_rotation_duration;
+    rotation_enabled = max_segment_size > 0 || max_segment_duration.count() > 0;
+    compress = conf.log_compression;
+    max_segments = conf.log_max_segments;
+
+    segment_index = 0;
+    finished_segments.clear();
+    OpenSegment();
+}
+
+const bool RotatingLogFile::IsOpen() const
+{
+    return file.is_open();
+}
+
+void RotatingLogFile::Close()
+{
+    if (file.is_open())
+    {
+        CloseSegment();
+    }
+}
+
+void RotatingLogFile::WriteLine(const std::string& line)
+{
+    file << line << '\n';
+    segment_size += line.size() + 1;
+
+    if (max_segment_size > 0 && segment_size >= max_segment_size)
+    {
+        CloseSegment();
+        OpenSegment();
+    }
+}
+
+void RotatingLogFile::Flush()
+{
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    if (max_segment_duration.count() > 0 &&
+        std::chrono::steady_clock::now() - segment_start >= max_segment_duration)
+    {
+        CloseSegment();
+        OpenSegment();
+        return;
+    }
+
+    file.flush();
+}
+
+const std::string RotatingLogFile::SegmentPath(const size_t index) const
+{
+    if (!rotation_enabled)
+    {
+        return base_path + extension;
+    }
+
+    char index_str[24];
+    std::snprintf(index_str, sizeof(index_str), "_%04zu", index);
+    return base_path + index_str + extension;
+}
+
+void RotatingLogFile::OpenSegment()
+{
+    segment_index += 1;
+    segment_size = 0;
+    segment_start = std::chrono::steady_clock::now();
+    file.open(SegmentPath(segment_index), std::ios::out);
+}
+
+void RotatingLogFile::CloseSegment()
+{
+    file.close();
+
+    const std::string path = SegmentPath(segment_index);
+    if (compress)
+    {
+        BackgroundCompressor::GetInstance().Compress(path);
+    }
+
+    finished_segments.push_back(path);
+    while (max_segments > 0 && finished_segments.size() > max_segments)
+    {
+        // Going through the compressor even without compression
+        // keeps this ordered after the segment compression job
+        BackgroundCompressor::GetInstance().Remove(finished_segments.front());
+        finished_segments.pop_front();
+    }
+}
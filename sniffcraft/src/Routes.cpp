@@ -0,0 +1,91 @@
+#include "sniffcraft/Routes.hpp"
+
+#include <picojson/picojson.h>
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+const std::vector<Route> LoadRoutes(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Error trying to open routes file: " + path);
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    file.close();
+
+    picojson::value json;
+    ss >> json;
+    const std::string err = picojson::get_last_error();
+    if (!err.empty())
+    {
+        throw std::runtime_error("Error parsing routes file at " + path + ": " + err);
+    }
+
+    if (!json.is<picojson::object>() || !json.get("Routes").is<picojson::array>())
+    {
+        throw std::runtime_error("Routes file " + path + " must contain a Routes array");
+    }
+
+    std::vector<Route> routes;
+    std::set<unsigned short> ports;
+    const picojson::array& list = json.get("Routes").get<picojson::array>();
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        if (!list[i].is<picojson::object>())
+        {
+            throw std::runtime_error("Route " + std::to_string(i) + " in " + path + " is not an object");
+        }
+
+        const picojson::value& listen_port = list[i].get("listen_port");
+        const picojson::value& server_address = list[i].get("server_address");
+        const picojson::value& logconf = list[i].get("logconf");
+
+        if (!listen_port.is<double>() || listen_port.get<double>() <= 0 || listen_port.get<double>() >= 65536)
+        {
+            throw std::runtime_error("Route " + std::to_string(i) + " in " + path + " has no valid listen_port");
+        }
+        if (!server_address.is<std::string>() || server_address.get<std::string>().empty())
+        {
+            throw std::runtime_error("Route " + std::to_string(i) + " in " + path + " has no server_address");
+        }
+
+        Route route;
+        route.listen_port = static_cast<unsigned short>(listen_port.get<double>());
+        route.server_address = server_address.get<std::string>();
+        route.logconf_path = logconf.is<std::string>() ? logconf.get<std::string>() : "";
+
+        const picojson::value& hosts = list[i].get("hosts");
+        if (hosts.is<picojson::object>())
+        {
+            const picojson::object& hosts_object = hosts.get<picojson::object>();
+            for (auto it = hosts_object.begin(); it != hosts_object.end(); ++it)
+            {
+                if (!it->second.is<std::string>() || it->second.get<std::string>().empty())
+                {
+                    throw std::runtime_error("Host " + it->first + " of route " + std::to_string(i) + " in " + path + " has no server address");
+                }
+                route.hosts.push_back({ it->first, it->second.get<std::string>() });
+            }
+        }
+
+        if (!ports.insert(route.listen_port).second)
+        {
+            throw std::runtime_error("Port " + std::to_string(route.listen_port) + " is used by more than one route in " + path);
+        }
+
+        routes.push_back(route);
+    }
+
+    if (routes.empty())
+    {
+        throw std::runtime_error("No route in " + path);
+    }
+
+    return routes;
+}
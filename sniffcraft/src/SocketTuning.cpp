@@ -0,0 +1,107 @@
+#include "sniffcraft/SocketTuning.hpp"
+
+#include <iostream>
+
+#if defined(TCP_KEEPIDLE)
+typedef asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPIDLE> keepalive_idle;
+#elif defined(TCP_KEEPALIVE)
+// macOS name
+typedef asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPALIVE> keepalive_idle;
+#endif
+#ifdef TCP_KEEPINTVL
+typedef asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPINTVL> keepalive_interval;
+#endif
+#ifdef TCP_KEEPCNT
+typedef asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPCNT> keepalive_count;
+#endif
+#ifdef TCP_USER_TIMEOUT
+typedef asio::detail::socket_option::integer<IPPROTO_TCP, TCP_USER_TIMEOUT> user_timeout;
+#endif
+#ifdef TCP_QUICKACK
+typedef asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK> quickack;
+#endif
+
+template<class Option>
+void SetSocketOption(asio::ip::tcp::socket& socket, const Option& option, const char* option_name, const std::string& leg_name)
+{
+    asio::error_code ec;
+    socket.set_option(option, ec);
+    if (ec)
+    {
+        std::cerr << "Can't set " << option_name << " on " << leg_name << " socket: " << ec.message() << std::endl;
+    }
+}
+
+void ReportUnsupportedOption(const char* option_name)
+{
+    std::cerr << option_name << " is not available on this platform, ignored" << std::endl;
+}
+
+void ApplySocketOptions(asio::ip::tcp::socket& socket, const SocketOptions& options, const std::string& leg_name)
+{
+    SetSocketOption(socket, asio::ip::tcp::no_delay(options.nodelay), "TCP_NODELAY", leg_name);
+
+    if (options.send_buffer > 0)
+    {
+        SetSocketOption(socket, asio::socket_base::send_buffer_size(options.send_buffer), "SO_SNDBUF", leg_name);
+    }
+    if (options.receive_buffer > 0)
+    {
+        SetSocketOption(socket, asio::socket_base::receive_buffer_size(options.receive_buffer), "SO_RCVBUF", leg_name);
+    }
+
+    if (options.keepalive)
+    {
+        SetSocketOption(socket, asio::socket_base::keep_alive(true), "SO_KEEPALIVE", leg_name);
+        if (options.keepalive_idle_s > 0)
+        {
+#if defined(TCP_KEEPIDLE) || defined(TCP_KEEPALIVE)
+            SetSocketOption(socket, keepalive_idle(options.keepalive_idle_s), "TCP_KEEPIDLE", leg_name);
+#else
+            ReportUnsupportedOption("TCP_KEEPIDLE");
+#endif
+        }
+        if (options.keepalive_interval_s > 0)
+        {
+#ifdef TCP_KEEPINTVL
+            SetSocketOption(socket, keepalive_interval(options.keepalive_interval_s), "TCP_KEEPINTVL", leg_name);
+#else
+            ReportUnsupportedOption("TCP_KEEPINTVL");
+#endif
+        }
+        if (options.keepalive_count > 0)
+        {
+#ifdef TCP_KEEPCNT
+            SetSocketOption(socket, keepalive_count(options.keepalive_count), "TCP_KEEPCNT", leg_name);
+#else
+            ReportUnsupportedOption("TCP_KEEPCNT");
+#endif
+        }
+    }
+
+    if (options.user_timeout_ms > 0)
+    {
+#ifdef TCP_USER_TIMEOUT
+        SetSocketOption(socket, user_timeout(static_cast<int>(options.user_timeout_ms)), "TCP_USER_TIMEOUT", leg_name);
+#else
+        ReportUnsupportedOption("TCP_USER_TIMEOUT");
+#endif
+    }
+
+    if (options.quickack)
+    {
+#ifdef TCP_QUICKACK
+        SetSocketOption(socket, quickack(true), "TCP_QUICKACK", leg_name);
+#else
+        ReportUnsupportedOption("TCP_QUICKACK");
+#endif
+    }
+}
+
+void RearmQuickAck(asio::ip::tcp::socket& socket)
+{
+#ifdef TCP_QUICKACK
+    asio::error_code ec;
+    socket.set_option(quickack(true), ec);
+#endif
+}
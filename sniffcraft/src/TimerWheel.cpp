@@ -0,0 +1,141 @@
+#include "sniffcraft/TimerWheel.hpp"
+
+TimerWheel::Entry::Entry()
+{
+    deadline = 0;
+    prev = nullptr;
+    next = nullptr;
+    scheduled = false;
+}
+
+TimerWheel::TimerWheel(asio::io_context& io_context, const std::chrono::milliseconds& tick_duration, const size_t num_slots) :
+    timer_(io_context),
+    tick_duration_(tick_duration),
+    start_time_(std::chrono::steady_clock::now()),
+    slots_(num_slots, nullptr)
+{
+    current_tick_ = 0;
+    num_entries_ = 0;
+    timer_running_ = false;
+}
+
+void TimerWheel::Schedule(Entry& entry, const unsigned long long deadline)
+{
+    Cancel(entry);
+
+    if (num_entries_ == 0)
+    {
+        // Nothing to fire, just catch up with the time spent idle
+        current_tick_ = ElapsedTicks();
+    }
+
+    // Never in the slot being processed, it would wait a full turn
+    entry.deadline = deadline > current_tick_ ? deadline : current_tick_ + 1;
+    Entry*& head = slots_[entry.deadline % slots_.size()];
+    entry.prev = nullptr;
+    entry.next = head;
+    if (head != nullptr)
+    {
+        head->prev = &entry;
+    }
+    head = &entry;
+    entry.scheduled = true;
+    num_entries_ += 1;
+
+    if (!timer_running_)
+    {
+        StartTimer();
+    }
+}
+
+void TimerWheel::Cancel(Entry& entry)
+{
+    if (!entry.scheduled)
+    {
+        return;
+    }
+
+    if (entry.prev != nullptr)
+    {
+        entry.prev->next = entry.next;
+    }
+    else
+    {
+        slots_[entry.deadline % slots_.size()] = entry.next;
+    }
+    if (entry.next != nullptr)
+    {
+        entry.next->prev = entry.prev;
+    }
+    entry.prev = nullptr;
+    entry.next = nullptr;
+    entry.scheduled = false;
+    num_entries_ -= 1;
+}
+
+const unsigned long long TimerWheel::CurrentTick() const
+{
+    // Not updated while the wheel is empty
+    return num_entries_ == 0 ? ElapsedTicks() : current_tick_;
+}
+
+const unsigned long long TimerWheel::Ticks(const std::chrono::milliseconds& duration) const
+{
+    return (duration.count() + tick_duration_.count() - 1) / tick_duration_.count();
+}
+
+void TimerWheel::StartTimer()
+{
+    timer_running_ = true;
+    timer_.expires_at(start_time_ + tick_duration_ * (current_tick_ + 1));
+    timer_.async_wait(std::bind(&TimerWheel::handle_tick, this, std::placeholders::_1));
+}
+
+void TimerWheel::handle_tick(const asio::error_code& ec)
+{
+    timer_running_ = false;
+    if (ec)
+    {
+        return;
+    }
+
+    // Process all the slots passed since the last tick,
+    // in case the io_context was busy when the timer expired
+    const unsigned long long target_tick = ElapsedTicks();
+    while (current_tick_ < target_tick && num_entries_ > 0)
+    {
+        current_tick_ += 1;
+        expired_.clear();
+        for (Entry* entry = slots_[current_tick_ % slots_.size()]; entry != nullptr; entry = entry->next)
+        {
+            // Entries further than one turn stay for a next round
+            if (entry->deadline <= current_tick_)
+            {
+                expired_.push_back(entry);
+            }
+        }
+        for (size_t i = 0; i < expired_.size(); ++i)
+        {
+            Cancel(*expired_[i]);
+        }
+        // Callbacks may schedule again or destroy their own entry
+        for (size_t i = 0; i < expired_.size(); ++i)
+        {
+            expired_[i]->callback();
+        }
+    }
+    if (current_tick_ < target_tick)
+    {
+        current_tick_ = target_tick;
+    }
+
+    if (num_entries_ > 0)
+    {
+        StartTimer();
+    }
+}
+
+const unsigned long long TimerWheel::ElapsedTicks() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time_).count() / tick_duration_.count();
+}
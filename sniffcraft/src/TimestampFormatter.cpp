@@ -0,0 +1,138 @@
+#include "sniffcraft/TimestampFormatter.hpp"
+
+#include <cstring>
+#include <ctime>
+
+// Write value with exactly width digits (left padded with zeros)
+inline void WriteDigits(unsigned long long value, const size_t width, char* output)
+{
+    for (size_t i = width; i > 0; --i)
+    {
+        output[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Write value with at least min_width digits and return the number of digits written
+inline const size_t WriteNumber(unsigned long long value, const size_t min_width, char* output)
+{
+    size_t width = 1;
+    for (unsigned long long v = value / 10; v > 0; v /= 10)
+    {
+        width += 1;
+    }
+    width = width < min_width ? min_width : width;
+    WriteDigits(value, width, output);
+    return width;
+}
+
+const size_t TimestampFormatter::MAX_LENGTH;
+
+TimestampFormatter::TimestampFormatter()
+{
+    start_time = std::chrono::system_clock::now();
+    cached_format = TimestampFormat::Relative;
+    cached_second = -1;
+    cached_prefix_length = 0;
+}
+
+void TimestampFormatter::SetStartTime(const std::chrono::system_clock::time_point& start_time_)
+{
+    start_time = start_time_;
+    cached_second = -1;
+}
+
+const size_t TimestampFormatter::Format(const TimestampFormat format,
+    const std::chrono::system_clock::time_point& date,
+    const std::chrono::steady_clock::time_point& monotonic_date,
+    char* output)
+{
+    switch (format)
+    {
+    case TimestampFormat::Relative:
+        return FormatRelative(date, output);
+    case TimestampFormat::Absolute:
+        return FormatAbsolute(date, output);
+    case TimestampFormat::Monotonic:
+        return FormatMonotonic(monotonic_date, output);
+    }
+    return 0;
+}
+
+const size_t TimestampFormatter::FormatRelative(const std::chrono::system_clock::time_point& date, char* output)
+{
+    long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(date - start_time).count();
+    // System clock can go backward
+    elapsed_ms = elapsed_ms < 0 ? 0 : elapsed_ms;
+
+    const long long second = elapsed_ms / 1000;
+    if (cached_format != TimestampFormat::Relative || cached_second != second)
+    {
+        // hh:mm:ss:
+        size_t length = WriteNumber(second / 3600, 2, cached_prefix);
+        cached_prefix[length++] = ':';
+        WriteDigits((second / 60) % 60, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = ':';
+        WriteDigits(second % 60, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = ':';
+
+        cached_prefix_length = length;
+        cached_second = second;
+        cached_format = TimestampFormat::Relative;
+    }
+
+    std::memcpy(output, cached_prefix, cached_prefix_length);
+    WriteDigits(elapsed_ms % 1000, 3, output + cached_prefix_length);
+    return cached_prefix_length + 3;
+}
+
+const size_t TimestampFormatter::FormatAbsolute(const std::chrono::system_clock::time_point& date, char* output)
+{
+    const long long since_epoch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(date.time_since_epoch()).count();
+    const long long second = since_epoch_ms / 1000;
+    if (cached_format != TimestampFormat::Absolute || cached_second != second)
+    {
+        // ISO 8601 in UTC: YYYY-MM-DDThh:mm:ss.
+        const std::time_t t = static_cast<std::time_t>(second);
+        std::tm utc;
+#ifdef _WIN32
+        gmtime_s(&utc, &t);
+#else
+        gmtime_r(&t, &utc);
+#endif
+        size_t length = WriteNumber(utc.tm_year + 1900, 4, cached_prefix);
+        cached_prefix[length++] = '-';
+        WriteDigits(utc.tm_mon + 1, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = '-';
+        WriteDigits(utc.tm_mday, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = 'T';
+        WriteDigits(utc.tm_hour, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = ':';
+        WriteDigits(utc.tm_min, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = ':';
+        WriteDigits(utc.tm_sec, 2, cached_prefix + length);
+        length += 2;
+        cached_prefix[length++] = '.';
+
+        cached_prefix_length = length;
+        cached_second = second;
+        cached_format = TimestampFormat::Absolute;
+    }
+
+    std::memcpy(output, cached_prefix, cached_prefix_length);
+    WriteDigits(since_epoch_ms % 1000, 3, output + cached_prefix_length);
+    output[cached_prefix_length + 3] = 'Z';
+    return cached_prefix_length + 4;
+}
+
+const size_t TimestampFormatter::FormatMonotonic(const std::chrono::steady_clock::time_point& monotonic_date, char* output)
+{
+    const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(monotonic_date.time_since_epoch()).count();
+    return WriteNumber(ns < 0 ? 0 : ns, 1, output);
+}
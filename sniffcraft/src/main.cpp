@@ -5,24 +5,31 @@ int main(int argc, char* argv[])
 {
    if (argc < 3)
    {
-      std::cerr << "usage: sniffcraft <client_port> <server_address> <optional:logconf_path>" << std::endl;
+      std::cerr << "usage: sniffcraft <client_port> <server_address> <optional:logconf_path>\n"
+          << "       sniffcraft --routes <routes_path>" << std::endl;
       return 1;
    }
 
-   const short client_port = static_cast<short>(std::atoi(argv[1]));
-   const std::string server_address = argv[2];
-   std::string logconf_path = "";
-
-   if (argc == 4)
-   {
-       logconf_path = argv[3];
-   }
-
    asio::io_context io_context;
 
    try
    {
-       Server server = Server(io_context, client_port, server_address, logconf_path);
+       std::vector<Route> routes;
+
+       if (std::string(argv[1]) == "--routes")
+       {
+           routes = LoadRoutes(argv[2]);
+       }
+       else
+       {
+           Route route;
+           route.listen_port = static_cast<unsigned short>(std::atoi(argv[1]));
+           route.server_address = argv[2];
+           route.logconf_path = argc == 4 ? argv[3] : "";
+           routes.push_back(route);
+       }
+
+       Server server(io_context, routes);
        io_context.run();
    }
    catch(std::exception& e)
@@ -3,11 +3,19 @@
 
 #include "sniffcraft/DNS/DNSMessage.hpp"
 #include "sniffcraft/DNS/DNSSrvData.hpp"
+#include "sniffcraft/LatencyStats.hpp"
+#include "sniffcraft/Metrics.hpp"
+#include "sniffcraft/Profiler.hpp"
 
+#include <ctime>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <utility>
 
+// At exit, time given to the logger service to write what is still queued
+const std::chrono::seconds LOG_DRAIN_TIMEOUT(5);
+
 const std::vector<std::string> SplitString(const std::string& s, const char delimiter)
 {
     std::vector<std::string> tokens;
@@ -20,38 +28,310 @@ const std::vector<std::string> SplitString(const std::string& s, const char deli
     return tokens;
 }
 
-Server::Server(asio::io_context& io_context, const unsigned short client_port,
-    const std::string& server_address, const std::string &logconf_path_) : 
+Server::Server(asio::io_context& io_context, const std::vector<Route>& routes) :
     io_context_(io_context),
-    acceptor_(io_context, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), client_port)),
-    logconf_path(logconf_path_)
+    next_worker_(0),
+    reuse_port_enabled_(false),
+    latency_timer_(io_context),
+    shutdown_signals_(io_context, SIGINT, SIGTERM)
+#if defined(SNIFFCRAFT_PROFILING) && !defined(_WIN32)
+    , profiler_signals_(io_context, SIGUSR1)
+#endif
+{
+    for (size_t i = 0; i < routes.size(); ++i)
+    {
+        std::unique_ptr<Listener> listener(new Listener());
+        listener->listen_port = routes[i].listen_port;
+        listener->config_watcher = std::unique_ptr<ConfigWatcher>(new ConfigWatcher(routes[i].logconf_path));
+        ResolveIpPortFromAddress(routes[i].server_address, listener->server_ip, listener->server_port);
+        if (!routes[i].hosts.empty())
+        {
+            listener->host_router = std::unique_ptr<HostRouter>(new HostRouter());
+            for (size_t j = 0; j < routes[i].hosts.size(); ++j)
+            {
+                Upstream upstream;
+                ResolveIpPortFromAddress(routes[i].hosts[j].second, upstream.ip, upstream.port);
+                std::cout << "Port " << routes[i].listen_port << ": " << routes[i].hosts[j].first << " --> "
+                    << upstream.ip << ":" << upstream.port << std::endl;
+                listener->host_router->Add(routes[i].hosts[j].first, upstream);
+            }
+        }
+        listeners_.push_back(std::move(listener));
+    }
+
+    std::shared_ptr<const Configuration> conf = listeners_[0]->config_watcher->GetConfiguration();
+    if (conf->metrics_enabled)
+    {
+        std::cout << "Serving metrics on http://127.0.0.1:" << conf->metrics_port << "/metrics" << std::endl;
+        metrics_server_ = std::unique_ptr<MetricsServer>(new MetricsServer(io_context_, conf->metrics_port));
+    }
+
+#ifdef ASIO_HAS_IO_URING
+    std::cout << "Using io_uring backend" << std::endl;
+#endif
+
+    if (conf->admission_max_connections > 0 || conf->admission_max_connections_per_ip > 0 ||
+        conf->admission_rate > 0.0 || conf->admission_rate_per_ip > 0.0)
+    {
+        admission_control_ = std::unique_ptr<AdmissionControl>(new AdmissionControl(*conf));
+    }
+
+    if (conf->decode_threads > 0)
+    {
+        std::cout << "Decoding packets on " << conf->decode_threads << " thread(s)" << std::endl;
+        decode_pool_ = std::unique_ptr<asio::thread_pool>(new asio::thread_pool(conf->decode_threads));
+    }
+
+    std::cout << "Writing session logs on " << conf->log_threads << " thread(s)" << std::endl;
+    logger_service_ = std::unique_ptr<LoggerService>(new LoggerService(conf->log_threads));
+
+    CreateWorkers(*conf);
+    for (size_t i = 0; i < listeners_.size(); ++i)
+    {
+        StartListening(*listeners_[i], *conf);
+    }
+
+    // Only started once all the routes are listening
+    for (size_t i = 0; i < worker_contexts_.size(); ++i)
+    {
+        asio::io_context* context = worker_contexts_[i].get();
+        worker_threads_.push_back(std::thread([context]() { context->run(); }));
+    }
+
+    StartLatencyTimer();
+    WaitShutdownSignal();
+#if defined(SNIFFCRAFT_PROFILING) && !defined(_WIN32)
+    WaitProfilerSignal();
+#endif
+}
+
+Server::~Server()
 {
-    ResolveIpPortFromAddress(server_address);
-    start_accept();
+    for (size_t i = 0; i < worker_guards_.size(); ++i)
+    {
+        worker_guards_[i].reset();
+    }
+    for (size_t i = 0; i < worker_contexts_.size(); ++i)
+    {
+        worker_contexts_[i]->stop();
+    }
+    for (size_t i = 0; i < worker_threads_.size(); ++i)
+    {
+        if (worker_threads_[i].joinable())
+        {
+            worker_threads_[i].join();
+        }
+    }
+
+    // No session runs anymore, the batches waiting on the pool are
+    // decoded (and their decoders destroyed) while the loggers can
+    // still be scheduled and the ConfigWatchers are still alive
+    if (decode_pool_ != nullptr)
+    {
+        decode_pool_->join();
+        decode_pool_.reset();
+    }
+
+    if (logger_service_ != nullptr && !logger_service_->Stop(LOG_DRAIN_TIMEOUT))
+    {
+        std::cerr << "Some log items could not be written before exiting" << std::endl;
+    }
 }
 
-void Server::start_accept()
+// 250 ms resolution, slots cover 256 s so most deadlines are hit on the first turn
+const std::chrono::milliseconds TIMER_WHEEL_TICK(250);
+const size_t TIMER_WHEEL_SLOTS = 1024;
+
+#ifdef SO_REUSEPORT
+typedef asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+#endif
+
+void Server::CreateWorkers(const Configuration& conf)
 {
-    MinecraftProxy* new_proxy = new MinecraftProxy(io_context_, logconf_path);
-    acceptor_.async_accept(new_proxy->ClientSocket(),
-        std::bind(&Server::handle_accept, this, new_proxy,
-            std::placeholders::_1));
+    reuse_port_enabled_ = conf.listen_reuse_port;
+#ifndef SO_REUSEPORT
+    if (reuse_port_enabled_)
+    {
+        std::cerr << "SO_REUSEPORT is not available on this platform, using only one listening socket" << std::endl;
+        reuse_port_enabled_ = false;
+    }
+#endif
+
+    timer_wheels_.push_back(std::unique_ptr<TimerWheel>(new TimerWheel(io_context_, TIMER_WHEEL_TICK, TIMER_WHEEL_SLOTS)));
+    for (unsigned int i = 1; i < conf.listen_workers; ++i)
+    {
+        worker_contexts_.push_back(std::unique_ptr<asio::io_context>(new asio::io_context()));
+        // Keep the context running even without pending operation
+        worker_guards_.push_back(asio::make_work_guard(*worker_contexts_.back()));
+        timer_wheels_.push_back(std::unique_ptr<TimerWheel>(new TimerWheel(*worker_contexts_.back(), TIMER_WHEEL_TICK, TIMER_WHEEL_SLOTS)));
+    }
 }
 
-void Server::handle_accept(MinecraftProxy* new_proxy, const asio::error_code& ec)
+void Server::StartListening(Listener& listener, const Configuration& conf)
 {
+    const asio::ip::tcp::endpoint endpoint(conf.listen_ipv6 ? asio::ip::tcp::v6() : asio::ip::tcp::v4(), listener.listen_port);
+    const int backlog = conf.listen_backlog > 0 ? conf.listen_backlog : static_cast<int>(asio::socket_base::max_listen_connections);
+    const size_t num_acceptors = reuse_port_enabled_ ? worker_contexts_.size() + 1 : 1;
+
+    for (size_t i = 0; i < num_acceptors; ++i)
+    {
+        asio::io_context& context = i == 0 ? io_context_ : *worker_contexts_[i - 1];
+        std::unique_ptr<asio::ip::tcp::acceptor> acceptor(new asio::ip::tcp::acceptor(context));
+        acceptor->open(endpoint.protocol());
+        acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+        if (conf.listen_ipv6)
+        {
+            // Also accept IPv4 clients
+            acceptor->set_option(asio::ip::v6_only(false));
+        }
+#ifdef SO_REUSEPORT
+        if (reuse_port_enabled_)
+        {
+            acceptor->set_option(reuse_port(true));
+        }
+#endif
+        acceptor->bind(endpoint);
+        acceptor->listen(backlog);
+        listener.acceptors.push_back(std::move(acceptor));
+    }
+
+    std::cout << "Listening on port " << listener.listen_port << (conf.listen_ipv6 ? " (IPv4 and IPv6)" : "")
+        << " for " << listener.server_ip << ":" << listener.server_port
+        << " with " << worker_contexts_.size() + 1 << " worker(s) and " << num_acceptors << " listening socket(s)" << std::endl;
+
+    for (size_t i = 0; i < listener.acceptors.size(); ++i)
+    {
+        start_accept(&listener, i);
+    }
+}
+
+void Server::start_accept(Listener* listener, const size_t acceptor_index)
+{
+    size_t worker = 0;
+    if (listener->acceptors.size() > 1)
+    {
+        // The session stays on the worker of its acceptor
+        worker = acceptor_index;
+    }
+    else if (!worker_contexts_.empty())
+    {
+        worker = next_worker_;
+        next_worker_ = (next_worker_ + 1) % (worker_contexts_.size() + 1);
+    }
+    asio::io_context* context = worker == 0 ? &io_context_ : worker_contexts_[worker - 1].get();
+
+    // Accepted as a bare socket of the worker context, the
+    // session is only created once the client is admitted
+    listener->acceptors[acceptor_index]->async_accept(*context,
+        std::bind(&Server::handle_accept, this, listener, acceptor_index, worker,
+            std::placeholders::_1, std::placeholders::_2));
+}
+
+void Server::handle_accept(Listener* listener, const size_t acceptor_index, const size_t worker, const asio::error_code& ec, asio::ip::tcp::socket client_socket)
+{
+    asio::error_code endpoint_ec;
+    asio::ip::tcp::endpoint client_endpoint;
     if (!ec)
     {
-        new_proxy->Start(server_ip_, server_port_);
+        client_endpoint = client_socket.remote_endpoint(endpoint_ec);
+    }
+
+    if (ec || endpoint_ec)
+    {
+        // Nothing to do, client_socket is closed when it goes out of scope
+    }
+    else if (admission_control_ != nullptr && !admission_control_->TryAdmit(client_endpoint.address()))
+    {
+        // Dropped before any session state (logger, decoder...) is created
+        Metrics::Add(MetricCounter::ConnectionsRejected);
     }
     else
     {
-        delete new_proxy;
+        asio::io_context& context = worker == 0 ? io_context_ : *worker_contexts_[worker - 1];
+        MinecraftProxy* new_proxy = new MinecraftProxy(context, std::move(client_socket), *listener->config_watcher, decode_pool_.get(),
+            listener->host_router.get(), timer_wheels_[worker].get(), admission_control_.get(), *logger_service_);
+
+        // Start the session from the thread running its context
+        const std::string server_ip = listener->server_ip;
+        const unsigned short server_port = listener->server_port;
+        const asio::ip::address client_address = client_endpoint.address();
+        asio::post(context, [new_proxy, server_ip, server_port, client_address]()
+            {
+                new_proxy->Start(server_ip, server_port, client_address);
+            });
+    }
+    start_accept(listener, acceptor_index);
+}
+
+void Server::StartLatencyTimer()
+{
+    // Interval is read each time so it follows conf changes
+    latency_timer_.expires_after(listeners_[0]->config_watcher->GetConfiguration()->latency_dump_interval);
+    latency_timer_.async_wait(std::bind(&Server::handle_latency_timer, this, std::placeholders::_1));
+}
+
+void Server::handle_latency_timer(const asio::error_code& ec)
+{
+    if (ec)
+    {
+        return;
     }
-    start_accept();
+
+    std::shared_ptr<const Configuration> conf = listeners_[0]->config_watcher->GetConfiguration();
+    if (conf->latency_stats_enabled && !conf->latency_stats_file.empty())
+    {
+        std::ofstream stats_file(conf->latency_stats_file, std::ios::out | std::ios::app);
+        if (stats_file.is_open())
+        {
+            const std::time_t now = std::time(nullptr);
+            char date[32];
+            std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+            stats_file << "Global latency stats at " << date << "\n"
+                << LatencyStats::GlobalToString(conf->latency_top_packets) << std::endl;
+        }
+    }
+
+    StartLatencyTimer();
+}
+
+void Server::WaitShutdownSignal()
+{
+    shutdown_signals_.async_wait(std::bind(&Server::handle_shutdown_signal, this,
+        std::placeholders::_1, std::placeholders::_2));
+}
+
+void Server::handle_shutdown_signal(const asio::error_code& ec, int signal_number)
+{
+    if (ec)
+    {
+        return;
+    }
+
+    std::cout << "Signal " << signal_number << " received, stopping" << std::endl;
+    io_context_.stop();
+}
+
+#if defined(SNIFFCRAFT_PROFILING) && !defined(_WIN32)
+void Server::WaitProfilerSignal()
+{
+    profiler_signals_.async_wait(std::bind(&Server::handle_profiler_signal, this,
+        std::placeholders::_1, std::placeholders::_2));
+}
+
+void Server::handle_profiler_signal(const asio::error_code& ec, int signal_number)
+{
+    if (ec)
+    {
+        return;
+    }
+
+    std::cout << Profiler::Summary() << std::endl;
+
+    WaitProfilerSignal();
 }
+#endif
 
-void Server::ResolveIpPortFromAddress(const std::string& address)
+void Server::ResolveIpPortFromAddress(const std::string& address, std::string& server_ip, unsigned short& server_port)
 {
     std::string addressOnly;
 
@@ -61,13 +341,13 @@ void Server::ResolveIpPortFromAddress(const std::string& address)
     {
         try
         {
-            server_port_ = std::stoi(splitted_port[1]);
-            server_ip_ = splitted_port[0];
+            server_port = std::stoi(splitted_port[1]);
+            server_ip = splitted_port[0];
             return;
         }
         catch (const std::exception&)
         {
-            server_port_ = 0;
+            server_port = 0;
         }
         addressOnly = splitted_port[0];
     }
@@ -75,7 +355,7 @@ void Server::ResolveIpPortFromAddress(const std::string& address)
     else
     {
         addressOnly = address;
-        server_port_ = 0;
+        server_port = 0;
     }
 
     // If port is unknown we first try a SRV DNS lookup
@@ -132,12 +412,12 @@ void Server::ResolveIpPortFromAddress(const std::string& address)
         auto iter2 = answer.GetAnswers()[0].GetRData().begin();
         size_t len2 = answer.GetAnswers()[0].GetRDLength();
         data.Read(iter2, len2);
-        server_ip_ = "";
+        server_ip = "";
         for (int i = 0; i < data.GetNameLabels().size(); ++i)
         {
-            server_ip_ += data.GetNameLabels()[i] + (i == data.GetNameLabels().size() - 1 ? "" : ".");
+            server_ip += data.GetNameLabels()[i] + (i == data.GetNameLabels().size() - 1 ? "" : ".");
         }
-        server_port_ = data.GetPort();
+        server_port = data.GetPort();
 
         std::cout << "SRV DNS lookup successful!" << std::endl;
         return;
@@ -146,7 +426,7 @@ void Server::ResolveIpPortFromAddress(const std::string& address)
 
     // If we are here either the port was given or the SRV failed 
     // In both cases we need to assume the given address is the correct one
-    server_port_ = (server_port_ == 0) ? 25565 : server_port_;
-    server_ip_ = addressOnly;
+    server_port = (server_port == 0) ? 25565 : server_port;
+    server_ip = addressOnly;
 }
 
@@ -0,0 +1,50 @@
+#include "sniffcraft/LatencyStats.hpp"
+
+#include <iostream>
+
+int failures = 0;
+
+void Check(const bool condition, const std::string& description)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << description << std::endl;
+        failures += 1;
+    }
+}
+
+// Percentile of a histogram with only one value recorded
+const long long SingleValuePercentile(const long long value)
+{
+    LatencyHistogram histogram;
+    histogram.Record(value);
+    return histogram.GetPercentile(100.0);
+}
+
+int main()
+{
+    const long long max_tracked = (1LL << 40) - 1;
+
+    // Largest value with its own bucket
+    Check(SingleValuePercentile(max_tracked) == max_tracked, "2^40 - 1 is in the last bucket");
+    // Values from 2^40 are clamped into the last bucket
+    Check(SingleValuePercentile(1LL << 40) == max_tracked, "2^40 is clamped into the last bucket");
+    Check(SingleValuePercentile((1LL << 41) - 1) == max_tracked, "2^41 - 1 is clamped into the last bucket");
+    Check(SingleValuePercentile(1LL << 62) == max_tracked, "2^62 is clamped into the last bucket");
+
+    // Small values are exact
+    Check(SingleValuePercentile(0) == 0, "0 has its own bucket");
+    Check(SingleValuePercentile(7) == 7, "7 has its own bucket");
+
+    LatencyHistogram histogram;
+    histogram.Record(1LL << 40);
+    histogram.Record((1LL << 41) - 1);
+    Check(histogram.GetCount() == 2, "boundary values are counted");
+    Check(histogram.GetMax() == (1LL << 41) - 1, "max keeps the real value");
+
+    if (failures == 0)
+    {
+        std::cout << "All tests passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}